@@ -8,6 +8,7 @@
 #ifndef binarytreeindex_hpp
 #define binarytreeindex_hpp
 
+#include <algorithm>
 #include "containerindex.hpp"
 
 namespace bal {
@@ -17,6 +18,7 @@ namespace bal {
     struct avl_tree_insertion_point_t: container_index_insertion_point_t {
         binary_tree_insertion_point_kind_t kind;
         container_offset_t offset; // instance offset for btipkRoot, index offset otherwise
+        container_offset_t instance_offset;
     };
     
     // iterates over all list items for particular instance
@@ -98,16 +100,120 @@ namespace bal {
         container_offset_t left_offset;
         container_offset_t right_offset;
         container_offset_t container_offset;
+        // height of the subtree, 1 for a leaf
+        uint32_t height;
     } avl_tree_index_item_t;
     
     // TODO: does not implement rollback while changing matched items within the transaction bound
     // for this implementation, this must be addressed externally e.g. by descendants
+    // trees are rebalanced on append, so that heights of the subtrees of any item differ by 1 at most
+    // this keeps the trees shallow when items arrive sorted, which is typical for generated formulas
     template<typename CONTAINER_DATA_T, typename Container<CONTAINER_DATA_T>::comparator_p comparator>
     class AvlTreesIndex: public BinaryTreesIndex<avl_tree_index_item_t, CONTAINER_DATA_T, avl_tree_insertion_point_t> {
     public:
         using base_t = BinaryTreesIndex<avl_tree_index_item_t, CONTAINER_DATA_T, avl_tree_insertion_point_t>;
         using insertion_point_t = typename base_t::insertion_point_t;
         
+    private:
+        inline uint32_t height(const container_offset_t offset) const {
+            return offset == CONTAINER_END ? 0 : this->data_[offset].height;
+        };
+        
+        inline void update_height(const container_offset_t offset) {
+            this->data_[offset].height = 1 + std::max(height(this->data_[offset].left_offset), height(this->data_[offset].right_offset));
+        };
+        
+        // points the parent of the item, or the instance if it is the root, to the replacement
+        inline void replace_child(const container_offset_t instance_offset, const container_offset_t offset, const container_offset_t replacement_offset) {
+            const container_offset_t parent_offset = this->data_[offset].parent_offset;
+            if (parent_offset == CONTAINER_END) {
+                this->instances_.data_[instance_offset] = replacement_offset;
+            } else if (this->data_[parent_offset].left_offset == offset) {
+                this->data_[parent_offset].left_offset = replacement_offset;
+            } else {
+                this->data_[parent_offset].right_offset = replacement_offset;
+            };
+            this->data_[replacement_offset].parent_offset = parent_offset;
+        };
+        
+        // the left child takes place of the item which becomes its right child
+        // returns offset of the new subtree root
+        container_offset_t rotate_right(const container_offset_t instance_offset, const container_offset_t offset) {
+            const container_offset_t left_offset = this->data_[offset].left_offset;
+            const container_offset_t left_right_offset = this->data_[left_offset].right_offset;
+            replace_child(instance_offset, offset, left_offset);
+            this->data_[offset].left_offset = left_right_offset;
+            if (left_right_offset != CONTAINER_END) {
+                this->data_[left_right_offset].parent_offset = offset;
+            };
+            this->data_[left_offset].right_offset = offset;
+            this->data_[offset].parent_offset = left_offset;
+            update_height(offset);
+            update_height(left_offset);
+            return left_offset;
+        };
+        
+        // the right child takes place of the item which becomes its left child
+        // returns offset of the new subtree root
+        container_offset_t rotate_left(const container_offset_t instance_offset, const container_offset_t offset) {
+            const container_offset_t right_offset = this->data_[offset].right_offset;
+            const container_offset_t right_left_offset = this->data_[right_offset].left_offset;
+            replace_child(instance_offset, offset, right_offset);
+            this->data_[offset].right_offset = right_left_offset;
+            if (right_left_offset != CONTAINER_END) {
+                this->data_[right_left_offset].parent_offset = offset;
+            };
+            this->data_[right_offset].left_offset = offset;
+            this->data_[offset].parent_offset = right_offset;
+            update_height(offset);
+            update_height(right_offset);
+            return right_offset;
+        };
+        
+        // links items [first + begin, first + end) into a balanced subtree in their order
+        // returns offset of the subtree root
+        container_offset_t link_balanced(const container_offset_t first, const container_size_t begin, const container_size_t end,
+                                         const container_offset_t parent_offset) {
+            if (begin == end) {
+                return CONTAINER_END;
+            };
+            const container_size_t middle = begin + (end - begin) / 2;
+            const container_offset_t offset = first + middle;
+            this->data_[offset].parent_offset = parent_offset;
+            this->data_[offset].left_offset = link_balanced(first, begin, middle, offset);
+            this->data_[offset].right_offset = link_balanced(first, middle + 1, end, offset);
+            update_height(offset);
+            return offset;
+        };
+        
+        // updates heights from the parent of a new leaf up to the root, rotating unbalanced subtrees
+        // stops once the height of a subtree remains the same; a single rotation at most is needed
+        void rebalance(const container_offset_t instance_offset, container_offset_t offset) {
+            while (offset != CONTAINER_END) {
+                const uint32_t height_before = this->data_[offset].height;
+                const container_offset_t left_offset = this->data_[offset].left_offset;
+                const container_offset_t right_offset = this->data_[offset].right_offset;
+                const int64_t balance = (int64_t)height(left_offset) - height(right_offset);
+                if (balance > 1) {
+                    if (height(this->data_[left_offset].left_offset) < height(this->data_[left_offset].right_offset)) {
+                        rotate_left(instance_offset, left_offset);
+                    };
+                    offset = rotate_right(instance_offset, offset);
+                } else if (balance < -1) {
+                    if (height(this->data_[right_offset].right_offset) < height(this->data_[right_offset].left_offset)) {
+                        rotate_right(instance_offset, right_offset);
+                    };
+                    offset = rotate_left(instance_offset, offset);
+                } else {
+                    update_height(offset);
+                };
+                if (this->data_[offset].height == height_before) {
+                    break;
+                };
+                offset = this->data_[offset].parent_offset;
+            };
+        };
+        
     public:
         AvlTreesIndex(const Container<CONTAINER_DATA_T>& container): base_t(container) {};
         
@@ -142,12 +248,33 @@ namespace bal {
                     insertion_point.kind == btipkRoot ? CONTAINER_END : insertion_point.offset,
                     CONTAINER_END,
                     CONTAINER_END,
-                    container_offset
+                    container_offset,
+                    1
                 };
                 this->size_++;
+                if (insertion_point.kind != btipkRoot) {
+                    rebalance(insertion_point.instance_offset, insertion_point.offset);
+                };
             };
         };
         
+        // appends items for objects sorted by comparator without equivalent ones to an empty instance
+        // the tree is linked balanced straight away, with no searching or rotating
+        void append_sorted(const container_offset_t instance_offset, const container_offset_t* const container_offsets,
+                           const container_size_t size) {
+            if (instance_offset >= this->instances_.size_) {
+                this->instances_.append(CONTAINER_END, instance_offset - this->instances_.size_ + 1);
+            };
+            assert(this->instances_.data_[instance_offset] == CONTAINER_END);
+            this->reserve(size);
+            const container_offset_t first = this->size_;
+            for (container_size_t i = 0; i < size; i++) {
+                this->data_[first + i].container_offset = container_offsets[i];
+            };
+            this->size_ += size;
+            this->instances_.data_[instance_offset] = link_balanced(first, 0, size, CONTAINER_END);
+        };
+        
         // find a match for p_object starting from the supplied index offset
         // returns container offset of the first matching object from the list if found,
         // otherwise returns CONTAINER_END
@@ -177,6 +304,7 @@ namespace bal {
                 this->instances_.append(CONTAINER_END, instance_offset - this->instances_.size_ + 1);
             };
             insertion_point.version_stamp = this->size_;
+            insertion_point.instance_offset = instance_offset;
             // take the root element from the instance
             container_offset_t offset = this->instances_.data_[instance_offset];
             if (offset != CONTAINER_END) {
@@ -210,6 +338,23 @@ namespace bal {
             };
             insertion_point.container_offset = CONTAINER_END;
         };
+        
+        // height of the deepest tree and the average height of non-empty trees, one tree per instance
+        // a search visits as many items as the height of the tree at most
+        void get_depth_stats(uint32_t& depth_max, double& depth_average) const {
+            depth_max = 0;
+            uint64_t depth_sum = 0;
+            container_size_t trees_size = 0;
+            for (container_offset_t i = 0; i < this->instances_.size_; i++) {
+                const container_offset_t offset = this->instances_.data_[i];
+                if (offset != CONTAINER_END) {
+                    depth_max = std::max(depth_max, this->data_[offset].height);
+                    depth_sum += this->data_[offset].height;
+                    trees_size++;
+                };
+            };
+            depth_average = trees_size > 0 ? (double)depth_sum / trees_size : 0;
+        };
     };
 };
 
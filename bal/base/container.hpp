@@ -9,8 +9,16 @@
 #define container_hpp
 
 #include <algorithm>
+#include <string>
+#include <system_error>
 #include <assert.h>
+#include <errno.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 namespace bal {
     
@@ -20,6 +28,23 @@ namespace bal {
     static const constexpr container_size_t CONTAINER_SIZE_MAX = UINT32_MAX - 1;
     static const constexpr container_size_t CONTAINER_END = UINT32_MAX;
     
+    // where the container keeps its items
+    //   cmHeap - malloc/realloc, the buffer is copied when it cannot grow in place
+    //   cmMapped - anonymous memory mapping, grows with mremap without copying
+    //   cmFile - shared mapping of a temporary file, for buffers larger than RAM;
+    //            the file is created in the directory given and removed straight away
+    // mapped buffers that cannot grow throw std::system_error with the errno, the items are kept then
+    //   cmExternal - memory owned elsewhere, e.g. a mapped snapshot, see Container::attach
+    typedef enum {cmHeap, cmMapped, cmFile, cmExternal} ContainerMemory;
+    
+    typedef struct {
+        ContainerMemory type;
+        // transparent huge pages for cmMapped
+        bool is_huge_pages;
+        // for cmFile
+        std::string directory;
+    } container_memory_t;
+    
     template<typename T>
     class Container {
     public:
@@ -37,9 +62,117 @@ namespace bal {
         // size of the allocated memory as a number of items of type T
         container_size_t allocated_size_ = 0;
         
+        ContainerMemory memory_ = cmHeap;
+        bool is_huge_pages_ = false;
+        // temporary file for cmFile
+        int fd_ = -1;
+        // size of the mapping in bytes, a multiple of the page size
+        size_t mapped_size_ = 0;
+        
     private:
+        // mapped buffers grow by whole pages, huge ones if asked for
+        inline size_t mapped_size(const container_size_t size) const {
+            const size_t page_size = is_huge_pages_ ? (size_t)1 << 21 : (size_t)sysconf(_SC_PAGESIZE);
+            return (size * sizeof(T) + page_size - 1) / page_size * page_size;
+        };
+        
+        // the file blocks are allocated rather than left sparse, so that a full disk is reported here
+        // rather than by SIGBUS once the mapping is written
+        inline void grow_file_(const size_t size) {
+            const int error = posix_fallocate(fd_, 0, size);
+            if (error != 0) {
+                throw std::system_error(error, std::generic_category(), "cannot grow the temporary file");
+            };
+        };
+        
+        // failing to release the space is not an error, the file is removed on close anyway
+        inline bool shrink_file_(const size_t size) {
+            return ftruncate(fd_, size) == 0;
+        };
+        
+        inline void resize_mapped_(const container_size_t size) {
+            if (size == 0) {
+                if (data_ != nullptr) {
+                    munmap(data_, mapped_size_);
+                    data_ = nullptr;
+                };
+                if (fd_ != -1) {
+                    shrink_file_(0);
+                };
+                mapped_size_ = 0;
+                allocated_size_ = 0;
+                size_ = 0;
+                return;
+            };
+            
+            const size_t new_mapped_size = mapped_size(size);
+            if (new_mapped_size == mapped_size_) {
+                return;
+            };
+            // the file must be as large as the mapping before the mapping is touched
+            if (fd_ != -1 && new_mapped_size > mapped_size_) {
+                grow_file_(new_mapped_size);
+            };
+            void* new_data = MAP_FAILED;
+            if (data_ == nullptr) {
+                new_data = fd_ != -1 ?
+                    mmap(nullptr, new_mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0) :
+                    mmap(nullptr, new_mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                size_ = 0;
+            } else {
+#ifdef MREMAP_MAYMOVE
+                // page tables are moved, the data is never copied
+                new_data = mremap(data_, mapped_size_, new_mapped_size, MREMAP_MAYMOVE);
+#else
+                if (fd_ != -1) {
+                    // the data remains in the file, the old mapping is kept until the new one succeeds
+                    new_data = mmap(nullptr, new_mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+                    if (new_data != MAP_FAILED) {
+                        munmap(data_, mapped_size_);
+                    };
+                } else {
+                    new_data = mmap(nullptr, new_mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                    if (new_data != MAP_FAILED) {
+                        memcpy(new_data, data_, std::min(mapped_size_, new_mapped_size));
+                        munmap(data_, mapped_size_);
+                    };
+                };
+#endif
+            };
+            if (new_data == MAP_FAILED) {
+                throw std::system_error(errno, std::generic_category(), "cannot map memory");
+            };
+            data_ = (T*)new_data;
+            if (fd_ != -1 && new_mapped_size < mapped_size_) {
+                shrink_file_(new_mapped_size);
+            };
+#ifdef MADV_HUGEPAGE
+            if (is_huge_pages_ && fd_ == -1) {
+                madvise(data_, new_mapped_size, MADV_HUGEPAGE);
+            };
+#endif
+            mapped_size_ = new_mapped_size;
+            allocated_size_ = (container_size_t)std::min<size_t>(new_mapped_size / sizeof(T), CONTAINER_SIZE_MAX);
+        };
+        
+        // copies the items of external memory to the heap
+        inline void detach_(const container_size_t size) {
+            T* const external_data = data_;
+            const container_size_t external_size = std::min(size_, size);
+            memory_ = cmHeap;
+            data_ = nullptr;
+            allocated_size_ = 0;
+            resize_(size);
+            std::copy(external_data, external_data + external_size, data_);
+            size_ = external_size;
+        };
+        
         inline void resize_(const container_size_t size) {
-            if (allocated_size_ != size) {
+            if (memory_ == cmExternal) {
+                detach_(size);
+            } else if (memory_ != cmHeap) {
+                resize_mapped_(size);
+            } else if (allocated_size_ != size) {
                 if (data_ != nullptr) {
                     if (size == 0) {
                         free(data_);
@@ -72,8 +205,45 @@ namespace bal {
         
         inline ~Container() {
             reset(0);
+            if (fd_ != -1) {
+                close(fd_);
+            };
+        };
+        
+        // selects where the items are kept, the container must be empty
+        // returns false if the temporary file cannot be created, the container stays on the heap then
+        bool set_memory(const container_memory_t& memory) {
+            reset(0);
+            if (fd_ != -1) {
+                close(fd_);
+                fd_ = -1;
+            };
+            memory_ = cmHeap;
+            is_huge_pages_ = memory.type == cmMapped && memory.is_huge_pages;
+            if (memory.type == cmFile) {
+                std::string file_name = (memory.directory.empty() ? std::string(".") : memory.directory) + "/cgraph-XXXXXX";
+                fd_ = mkstemp(&file_name[0]);
+                if (fd_ == -1) {
+                    return false;
+                };
+                unlink(file_name.c_str());
+            };
+            memory_ = memory.type;
+            return true;
+        };
+        
+        // refers to items owned elsewhere without copying them; nothing is freed
+        // the items are copied to the heap once the container is resized, so they can be read only
+        inline void attach(T* const data, const container_size_t size) {
+            reset(0);
+            memory_ = cmExternal;
+            data_ = data;
+            size_ = size;
+            allocated_size_ = size;
         };
         
+        inline ContainerMemory memory() const { return memory_; };
+        
         // number of bytes used to store actual data; used not allocated
         inline size_t memory_size() const { return size_ * sizeof(T); };
         
@@ -36,6 +36,7 @@ namespace bal {
         static_assert(std::is_base_of<container_index_insertion_point_t, INSERTION_POINT_T>::value, "Invalid type for INSERTION_POINT_T");
         
     public:
+        using index_data_t = INDEX_DATA_T;
         using container_data_t = CONTAINER_DATA_T;
         using instance_iterator_t = INSTANCE_ITERATOR_T;
         using insertion_point_t = INSERTION_POINT_T;
@@ -71,6 +72,18 @@ namespace bal {
             instances_.reset(instances_size);
         };
         
+        // items and instances as they are stored, e.g. to be saved
+        inline const Container<INDEX_DATA_T>& items() const { return *this; };
+        inline const Container<container_offset_t>& instances() const { return instances_; };
+        
+        // refers to items and instances stored elsewhere, see Container::attach
+        virtual void attach(INDEX_DATA_T* const items, const container_size_t items_size,
+                            container_offset_t* const instances, const container_size_t instances_size) {
+            assert(transaction_size_ == CONTAINER_END);
+            Container<INDEX_DATA_T>::attach(items, items_size);
+            instances_.attach(instances, instances_size);
+        };
+        
         virtual size_t memory_size() const {
             return Container<INDEX_DATA_T>::memory_size() + instances_.memory_size();
         };
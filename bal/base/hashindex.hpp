@@ -0,0 +1,289 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef hashindex_hpp
+#define hashindex_hpp
+
+#include <algorithm>
+#include <vector>
+#include "containerindex.hpp"
+
+namespace bal {
+
+    struct hash_index_insertion_point_t: container_index_insertion_point_t {
+        uint32_t hash;
+        container_offset_t instance_offset;
+        // index offset of the matching item if found, otherwise the empty slot to take
+        container_offset_t offset;
+    };
+
+    typedef struct {
+        container_offset_t container_offset;
+        // next item of the same instance, the most recent item comes first
+        container_offset_t next_offset;
+        uint32_t hash;
+    } hash_index_item_t;
+
+    // must return the same value for the objects equal according to the comparator
+    template<typename T>
+    using hash_function_p = uint32_t (*)(const T* const);
+
+    template<typename CONTAINER_DATA_T, typename Container<CONTAINER_DATA_T>::comparator_p, hash_function_p<CONTAINER_DATA_T>>
+    class HashIndexInstanceOffsetIterator;
+
+    // finds an object in one probe sequence of a flat hash table whatever the instance
+    // items of each instance are also linked into a list so that they can be iterated
+    // the table holds item offsets, open addressing with linear probing, at most half full
+    // same as AvlTreesIndex, an equivalent item is replaced rather than appended
+    template<typename CONTAINER_DATA_T, typename Container<CONTAINER_DATA_T>::comparator_p comparator, hash_function_p<CONTAINER_DATA_T> hash>
+    class HashIndex: public ContainerIndex<hash_index_item_t, CONTAINER_DATA_T, HashIndexInstanceOffsetIterator<CONTAINER_DATA_T, comparator, hash>, hash_index_insertion_point_t> {
+    public:
+        using base_t = ContainerIndex<hash_index_item_t, CONTAINER_DATA_T, HashIndexInstanceOffsetIterator<CONTAINER_DATA_T, comparator, hash>, hash_index_insertion_point_t>;
+        using insertion_point_t = typename base_t::insertion_point_t;
+
+        template<typename T, typename Container<T>::comparator_p, hash_function_p<T>>
+        friend class HashIndexInstanceOffsetIterator;
+
+    private:
+        static const constexpr container_size_t SLOTS_SIZE_MIN = 16;
+
+        std::vector<container_offset_t> slots_;
+
+        inline container_offset_t home_slot(const uint32_t hash_value) const {
+            return hash_value & (container_offset_t)(slots_.size() - 1);
+        };
+
+        inline container_offset_t next_slot(const container_offset_t slot) const {
+            return (slot + 1) & (container_offset_t)(slots_.size() - 1);
+        };
+
+        // first empty slot for the hash, the object must not be in the table
+        inline container_offset_t empty_slot(const uint32_t hash_value) const {
+            container_offset_t slot = home_slot(hash_value);
+            while (slots_[slot] != CONTAINER_END) {
+                slot = next_slot(slot);
+            };
+            return slot;
+        };
+
+        // smallest table that keeps index_size items at most half full
+        static inline size_t slots_size(const container_size_t index_size) {
+            size_t result = SLOTS_SIZE_MIN;
+            while (result < (size_t)index_size * 2) {
+                result <<= 1;
+            };
+            return result;
+        };
+        
+        void rehash(const size_t slots_size) {
+            slots_.assign(slots_size, CONTAINER_END);
+            for (container_offset_t i = 0; i < this->size_; i++) {
+                slots_[empty_slot(this->data_[i].hash)] = i;
+            };
+        };
+
+    protected:
+        // drops the items appended after the transaction began
+        // items replaced within the transaction are not restored, same as for AvlTreesIndex
+        virtual void rollback(const container_size_t size,
+                              const container_size_t instances_size,
+                              const container_size_t container_size) override {
+            base_t::rollback(size, instances_size, container_size);
+            // each item links to an earlier one, so the remaining items of a list follow the dropped ones
+            for (container_offset_t i = 0; i < this->instances_.size_; i++) {
+                container_offset_t offset = this->instances_.data_[i];
+                while (offset != CONTAINER_END && offset >= this->size_) {
+                    offset = this->data_[offset].next_offset;
+                };
+                this->instances_.data_[i] = offset;
+            };
+            rehash(slots_.size());
+        };
+
+        // removes all items keeping the instances
+        void clear() {
+            this->size_ = 0;
+            std::fill(this->instances_.data_, this->instances_.data_ + this->instances_.size_, CONTAINER_END);
+            std::fill(slots_.begin(), slots_.end(), CONTAINER_END);
+        };
+
+    public:
+        HashIndex(const Container<CONTAINER_DATA_T>& container): base_t(container) {};
+
+        virtual size_t memory_size() const override {
+            return base_t::memory_size() + slots_.size() * sizeof(container_offset_t);
+        };
+
+        virtual void reset(const container_size_t instances_size, const container_size_t index_size) override {
+            base_t::reset(instances_size, index_size);
+            slots_.assign(slots_size(index_size), CONTAINER_END);
+        };
+        
+        // the table is not stored with the items, it is rebuilt
+        virtual void attach(hash_index_item_t* const items, const container_size_t items_size,
+                            container_offset_t* const instances, const container_size_t instances_size) override {
+            base_t::attach(items, items_size, instances, instances_size);
+            rehash(slots_size(items_size));
+        };
+
+        inline void append(const insertion_point_t& insertion_point, const container_size_t container_offset) {
+            assert(insertion_point.version_stamp == this->size_);
+            assert(insertion_point.instance_offset < this->instances_.size_);
+            if (insertion_point.container_offset != CONTAINER_END) {
+                assert(insertion_point.offset < this->size_);
+                this->data_[insertion_point.offset].container_offset = container_offset;
+            } else {
+                container_offset_t slot = insertion_point.offset;
+                if ((size_t)(this->size_ + 1) * 2 > slots_.size()) {
+                    rehash(std::max<size_t>(slots_.size() * 2, SLOTS_SIZE_MIN));
+                    slot = empty_slot(insertion_point.hash);
+                };
+                this->reserve(1);
+                this->data_[this->size_] = {
+                    container_offset,
+                    this->instances_.data_[insertion_point.instance_offset],
+                    insertion_point.hash
+                };
+                this->instances_.data_[insertion_point.instance_offset] = this->size_;
+                slots_[slot] = this->size_;
+                this->size_++;
+            };
+        };
+
+        // appends items for objects without equivalent ones in the index or among themselves
+        // same as AvlTreesIndex::append_sorted, though the order does not matter here
+        void append_sorted(const container_offset_t instance_offset, const container_offset_t* const container_offsets,
+                           const container_size_t size) {
+            if (instance_offset >= this->instances_.size_) {
+                this->instances_.append(CONTAINER_END, instance_offset - this->instances_.size_ + 1);
+            };
+            if ((size_t)(this->size_ + size) * 2 > slots_.size()) {
+                size_t slots_size = std::max<size_t>(slots_.size(), SLOTS_SIZE_MIN);
+                while ((size_t)(this->size_ + size) * 2 > slots_size) {
+                    slots_size <<= 1;
+                };
+                rehash(slots_size);
+            };
+            this->reserve(size);
+            for (container_size_t i = 0; i < size; i++) {
+                const uint32_t hash_value = hash(this->container_.data_ + container_offsets[i]);
+                this->data_[this->size_] = {
+                    container_offsets[i],
+                    this->instances_.data_[instance_offset],
+                    hash_value
+                };
+                this->instances_.data_[instance_offset] = this->size_;
+                slots_[empty_slot(hash_value)] = this->size_;
+                this->size_++;
+            };
+        };
+
+        // returns container offset of the matching object if found, otherwise CONTAINER_END
+        inline container_offset_t find(const container_offset_t instance_offset, const CONTAINER_DATA_T* const p_object) const {
+            if (slots_.empty()) {
+                return CONTAINER_END;
+            };
+            const uint32_t hash_value = hash(p_object);
+            for (container_offset_t slot = home_slot(hash_value); slots_[slot] != CONTAINER_END; slot = next_slot(slot)) {
+                const hash_index_item_t& item = this->data_[slots_[slot]];
+                if (item.hash == hash_value && comparator(p_object, this->container_.data_ + item.container_offset) == 0) {
+                    return item.container_offset;
+                };
+            };
+            return CONTAINER_END;
+        };
+
+        // find a match for p_object, same as AvlTreesIndex::find
+        // the insertion point refers to either the matching item or the empty slot for a new one
+        inline void find(const container_offset_t instance_offset, const CONTAINER_DATA_T* const p_object, insertion_point_t &insertion_point) {
+            if (instance_offset >= this->instances_.size_) {
+                // update instances offset table if necessary
+                this->instances_.append(CONTAINER_END, instance_offset - this->instances_.size_ + 1);
+            };
+            if (slots_.empty()) {
+                rehash(SLOTS_SIZE_MIN);
+            };
+            insertion_point.version_stamp = this->size_;
+            insertion_point.instance_offset = instance_offset;
+            insertion_point.hash = hash(p_object);
+            container_offset_t slot = home_slot(insertion_point.hash);
+            while (slots_[slot] != CONTAINER_END) {
+                const hash_index_item_t& item = this->data_[slots_[slot]];
+                if (item.hash == insertion_point.hash && comparator(p_object, this->container_.data_ + item.container_offset) == 0) {
+                    insertion_point.offset = slots_[slot];
+                    insertion_point.container_offset = item.container_offset;
+                    return;
+                };
+                slot = next_slot(slot);
+            };
+            insertion_point.offset = slot;
+            insertion_point.container_offset = CONTAINER_END;
+        };
+
+        // longest and average number of items a successful search visits
+        void get_depth_stats(uint32_t& depth_max, double& depth_average) const {
+            depth_max = 0;
+            uint64_t depth_sum = 0;
+            for (container_offset_t slot = 0; slot < slots_.size(); slot++) {
+                if (slots_[slot] != CONTAINER_END) {
+                    const uint32_t depth = ((slot - home_slot(this->data_[slots_[slot]].hash)) & (container_offset_t)(slots_.size() - 1)) + 1;
+                    depth_max = std::max(depth_max, depth);
+                    depth_sum += depth;
+                };
+            };
+            depth_average = this->size_ > 0 ? (double)depth_sum / this->size_ : 0;
+        };
+    };
+
+    // iterates over all items of the particular instance in the comparator order
+    // the items are collected and sorted when positioned at the instance
+    template<typename CONTAINER_DATA_T, typename Container<CONTAINER_DATA_T>::comparator_p comparator, hash_function_p<CONTAINER_DATA_T> hash>
+    class HashIndexInstanceOffsetIterator {
+    public:
+        using index_t = HashIndex<CONTAINER_DATA_T, comparator, hash>;
+
+    protected:
+        const index_t& index_;
+        std::vector<container_offset_t> container_offsets_;
+        size_t position_ = 0;
+
+        inline container_offset_t current() const {
+            return position_ < container_offsets_.size() ? container_offsets_[position_] : CONTAINER_END;
+        };
+
+    public:
+        HashIndexInstanceOffsetIterator(const index_t& index): index_(index) {};
+
+        // positions at the first item for the given instance
+        // returns offset of the corresponding container data element or CONTAINER_END
+        inline const container_offset_t first(const container_offset_t instance_offset) {
+            container_offsets_.clear();
+            position_ = 0;
+            container_offset_t offset = instance_offset >= index_.instances_.size_ ? CONTAINER_END : index_.instances_.data_[instance_offset];
+            while (offset != CONTAINER_END) {
+                container_offsets_.push_back(index_.data_[offset].container_offset);
+                offset = index_.data_[offset].next_offset;
+            };
+            const CONTAINER_DATA_T* const data = index_.container_.data_;
+            std::sort(container_offsets_.begin(), container_offsets_.end(), [data](const container_offset_t lhs, const container_offset_t rhs) {
+                return comparator(data + lhs, data + rhs) < 0;
+            });
+            return current();
+        };
+
+        // moves to the next item for the stored instance
+        // returns offset of the corresponding container data element or CONTAINER_END
+        inline const container_offset_t next() {
+            if (position_ < container_offsets_.size()) {
+                position_++;
+            };
+            return current();
+        };
+    };
+};
+
+#endif /* hashindex_hpp */
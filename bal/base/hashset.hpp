@@ -0,0 +1,138 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef hashset_hpp
+#define hashset_hpp
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+namespace bal {
+
+    // set of non-zero 64 bit keys, open addressing with linear probing in a single flat array
+    // 0 marks an empty slot; capacity is a power of 2 and the table is kept at most half full
+    class UInt64HashSet {
+    private:
+        static const constexpr uint64_t EMPTY_KEY = 0;
+        static const constexpr size_t CAPACITY_MIN = 16;
+
+        uint64_t* data_ = nullptr;
+        size_t capacity_ = 0;
+        size_t size_ = 0;
+        // capacity_ == 1 << (64 - shift_)
+        unsigned shift_ = 64;
+
+        // fibonacci hashing; the upper bits of the product are mixed from all bits of the key
+        inline size_t slot(const uint64_t key) const {
+            return (size_t)((key * 0x9E3779B97F4A7C15ull) >> shift_);
+        };
+
+        // the set is kept as it is if the memory cannot be allocated
+        void rehash(const size_t capacity) {
+            uint64_t* const data = data_;
+            const size_t data_capacity = capacity_;
+
+            uint64_t* const new_data = (uint64_t*)calloc(capacity, sizeof(uint64_t));
+            if (new_data == nullptr) {
+                throw std::bad_alloc();
+            };
+            data_ = new_data;
+            capacity_ = capacity;
+            shift_ = 64;
+            for (size_t i = capacity; i > 1; i >>= 1) {
+                shift_--;
+            };
+
+            for (size_t i = 0; i < data_capacity; i++) {
+                if (data[i] != EMPTY_KEY) {
+                    size_t index = slot(data[i]);
+                    while (data_[index] != EMPTY_KEY) {
+                        index = (index + 1) & (capacity_ - 1);
+                    };
+                    data_[index] = data[i];
+                };
+            };
+            free(data);
+        };
+
+    public:
+        UInt64HashSet() = default;
+        UInt64HashSet(const UInt64HashSet&) = delete;
+        UInt64HashSet& operator = (const UInt64HashSet&) = delete;
+
+        inline ~UInt64HashSet() {
+            free(data_);
+        };
+
+        // prepares the set for the given number of keys without rehashing
+        void reserve(const size_t size) {
+            size_t capacity = CAPACITY_MIN;
+            while (capacity < size * 2) {
+                capacity <<= 1;
+            };
+            if (capacity > capacity_) {
+                rehash(capacity);
+            };
+        };
+
+        void clear() {
+            if (data_ != nullptr) {
+                memset(data_, 0, capacity_ * sizeof(uint64_t));
+            };
+            size_ = 0;
+        };
+
+        // returns true if the key is new, false if it is in the set already
+        inline bool insert(const uint64_t key) {
+            assert(key != EMPTY_KEY);
+            if ((size_ + 1) * 2 > capacity_) {
+                rehash(capacity_ > 0 ? capacity_ * 2 : CAPACITY_MIN);
+            };
+            size_t index = slot(key);
+            while (data_[index] != EMPTY_KEY) {
+                if (data_[index] == key) {
+                    return false;
+                };
+                index = (index + 1) & (capacity_ - 1);
+            };
+            data_[index] = key;
+            size_++;
+            return true;
+        };
+
+        inline bool contains(const uint64_t key) const {
+            if (size_ > 0) {
+                size_t index = slot(key);
+                while (data_[index] != EMPTY_KEY) {
+                    if (data_[index] == key) {
+                        return true;
+                    };
+                    index = (index + 1) & (capacity_ - 1);
+                };
+            };
+            return false;
+        };
+
+        inline size_t size() const { return size_; };
+        inline size_t memory_size() const { return capacity_ * sizeof(uint64_t); };
+
+        // calls f(key) for each key, in no particular order
+        template<typename F>
+        void for_each(F f) const {
+            for (size_t i = 0; i < capacity_; i++) {
+                if (data_[i] != EMPTY_KEY) {
+                    f(data_[i]);
+                };
+            };
+        };
+    };
+};
+
+#endif /* hashset_hpp */
@@ -8,13 +8,17 @@
 #ifndef cnf_hpp
 #define cnf_hpp
 
+#include <memory>
 #include <vector>
 #include "container.hpp"
 #include "binarytreeindex.hpp"
+#include "hashindex.hpp"
+#include "sortingnetwork.hpp"
 #include "variables.hpp"
 #include "variablesarray.hpp"
 #include "formula.hpp"
 #include "cnfclauses.hpp"
+#include "cnfcompressed.hpp"
 
 namespace bal {
     class CnfProcessor;
@@ -36,11 +40,31 @@ namespace bal {
         CnfL0Index(const Container<uint32_t>& container): base_t(container) {};
     };
     
+    // alternative to CnfL0Index, finds a clause with a single hash lookup rather than
+    // a tree search with compare_clauses on each level; clauses of each variable are
+    // still iterated sorted, but they are sorted on each iteration
+    class CnfHashIndex: public HashIndex<uint32_t, &compare_clauses, &hash_clause> {
+    public:
+        using base_t = HashIndex<uint32_t, &compare_clauses, &hash_clause>;
+        using insertion_point_t = typename base_t::insertion_point_t;
+        
+    protected:
+        // rebuild the index on rollback same as CnfL0Index
+        virtual void rollback(const container_size_t size,
+                              const container_size_t instances_size,
+                              const container_size_t container_size) override;
+        
+    public:
+        CnfHashIndex(const Container<uint32_t>& container): base_t(container) {};
+    };
+    
     class Cnf: public Formula {
     public:
         class CnfVariableGenerator: public VariableGenerator { friend class Cnf; };
         
         friend class CnfProcessor;
+        friend class CnfSnapshotStreamWriter;
+        friend class CnfSnapshotReader;
 
         // ADD_NAIVE enforces encoding of simple binary addition with carry
         static const bool constexpr ADD_NAIVE_DEFAULT = false;
@@ -63,7 +87,12 @@ namespace bal {
         static const uint32_t constexpr XOR_MAX_ARGS_MAX = 10;
         
         // index data types
+        // the hash index is selected at build time, see CMakeLists.txt
+#ifdef BAL_CNF_HASH_INDEX
+        using l0_index_t = CnfHashIndex;
+#else
         using l0_index_t = CnfL0Index;
+#endif
         
     private:
         // the buffer is a sequence of 32 bit words
@@ -86,6 +115,12 @@ namespace bal {
         // 0 means none
         container_offset_t immutable_offset_;
         
+        // non-aggregated clauses ignored because the same clause exists already
+        clauses_size_t duplicate_clauses_size_;
+        
+        // where clauses_ and buffers of the same size keep their data
+        container_memory_t clauses_memory_ = {cmHeap, false, std::string()};
+        
         CnfVariableGenerator variable_generator_;
         
         // generation options
@@ -93,6 +128,12 @@ namespace bal {
         uint32_t xor_max_args_;
         bool add_naive_;
         
+        // keeps memory the containers are attached to, e.g. a mapped snapshot
+        std::shared_ptr<void> external_data_;
+        
+        // replaces clauses_ once the formula is compressed, see compress_clauses
+        std::unique_ptr<CnfCompressedClauses> compressed_clauses_;
+        
     private:
         // assume the clause is new
         // search for the same clause
@@ -104,10 +145,9 @@ namespace bal {
         // avoid_merging forces to append new clause and prevents merging with an existing one
         template<bool avoid_merging>
         inline void __append_clause(l0_index_t::insertion_point_t& l0_insertion_point) {
-            __append_clause_++;
+            _statistics_increment(scAppendClause);
             
             uint32_t* const p_clause = clauses_.data_ + clauses_.size_;
-            literalid_t* const literals = p_clause + 1;
             const clause_size_t literals_size = *p_clause & 0xFFFF;
             
             assert(literals_size != 0);
@@ -121,15 +161,7 @@ namespace bal {
             // header + uncomplemented literals if needed
             if (literals_size <= 4) {
                 if ((*p_clause & 0xFFFF0000) == 0) {
-                    uint16_t clause_bitmap = 0;
-                    for (auto i = 0; i < literals_size; i++) {
-                        if (literals[i] & 0x1) {
-                            clause_bitmap |= 0x1 << i;
-                        } else {
-                            literals[i] |= 0x1;
-                        };
-                    };
-                    *p_clause = literals_size | (0x1 << (16 + clause_bitmap));
+                    aggregate_clause(p_clause);
                 } else {
                     assert(literals_size < 1 || !literal_t__is_negation(p_clause[1]));
                     assert(literals_size < 2 || !literal_t__is_negation(p_clause[2]));
@@ -145,6 +177,7 @@ namespace bal {
             // find insertion pont at the same time
             if (!l0_index_.is_valid_insertion_point(l0_insertion_point)) {
                 l0_index_.find(literal_t__variable_id(_clause_literal(p_clause, 0)), p_clause, l0_insertion_point);
+                _statistics_increment(l0_insertion_point.container_offset != CONTAINER_END ? scFindClauseFound : scFindClauseUnfound);
             };
             const container_offset_t existing_offset = l0_insertion_point.container_offset;
             
@@ -166,11 +199,9 @@ namespace bal {
                 // a matching aggregated clause is found; it is enough to merge headers
                 clauses_.data_[existing_offset] |= *p_clause;
             } else {
-                // a duplicate for an existing non-aggregated clause
-                /* deal with this later, ok if external, bad if derived */
-                __print_clause(existing_offset);
-                __print_clause(clauses_.size_);
-                assert(false);
+                // a duplicate for an existing non-aggregated clause, common in real inputs
+                // the clause is not committed, the formula remains the same
+                duplicate_clauses_size_++;
             };
         };
         
@@ -192,9 +223,13 @@ namespace bal {
             clauses_.reset(clauses_size << 2); // set initial buffer with 4 words per clause
             l0_index_.reset(variables_size, clauses_size);
             immutable_offset_ = 0;
+            duplicate_clauses_size_ = 0;
             add_max_args_ = ADD_MAX_ARGS_DEFAULT;
             xor_max_args_ = XOR_MAX_ARGS_DEFAULT;
             add_naive_ = ADD_NAIVE_DEFAULT;
+            // the containers do not refer to it after the reset
+            external_data_.reset();
+            compressed_clauses_.reset();
         };
 
         const Container<uint32_t>& get_clauses() const { return clauses_; };
@@ -204,15 +239,98 @@ namespace bal {
         
         virtual const variables_size_t variables_size() const override { return variable_generator_.next(); };
 
-        const bool is_empty() const override { return clauses_.size_ == 0; };
+        const bool is_empty() const override { return clauses_.size_ == 0 && !is_compressed(); };
+        
+        // compresses the clauses to take less memory, for formulas that are only read afterwards
+        // the clauses index is released, clauses cannot be added until the formula is initialized again
+        // the clauses remain available through split_clauses and for_each_clause only
+        void compress_clauses() {
+            assert(immutable_offset_ == 0);
+            compressed_clauses_.reset(new CnfCompressedClauses());
+            compressed_clauses_->encode(clauses_.data_, clauses_.size_);
+            clauses_.reset(0);
+            l0_index_.reset(0, 0);
+        };
+        
+        const bool is_compressed() const { return compressed_clauses_ != nullptr; };
+        
+        // clauses are iterated by positions: word offsets, or block numbers once compressed
+        // the end position of all clauses
+        inline uint32_t clauses_end() const {
+            return is_compressed() ? compressed_clauses_->blocks_size() : clauses_.size_;
+        };
+        
+        // splits the clauses into ranges_size ranges of about the same size for processing in parallel
+        // range i is [positions[i], positions[i + 1]), first_clauses[i] is the number of its first clause
+        // returns the number of clauses; positions and first_clauses must have room for ranges_size + 1 items
+        inline clauses_size_t split_clauses(const unsigned ranges_size, uint32_t* const positions, clauses_size_t* const first_clauses) const {
+            if (!is_compressed()) {
+                return bal::split_clauses(clauses_.data_, clauses_.size_, ranges_size, positions, first_clauses);
+            };
+            const uint32_t blocks_size = compressed_clauses_->blocks_size();
+            for (unsigned i = 0; i <= ranges_size; i++) {
+                positions[i] = (uint32_t)((uint64_t)blocks_size * i / ranges_size);
+                first_clauses[i] = std::min<clauses_size_t>(positions[i] * CnfCompressedClauses::BLOCK_CLAUSES,
+                                                            compressed_clauses_->clauses_size());
+            };
+            return compressed_clauses_->clauses_size();
+        };
+        
+        // calls f(p_clause) for each clause within the positions in order
+        // p_clause points to a decoded copy if compressed, it is valid within the call only
+        template<typename F>
+        void for_each_clause(const uint32_t begin, const uint32_t end, F f) const {
+            if (!is_compressed()) {
+                for (uint32_t offset = begin; offset < end; offset += _clause_memory_size(clauses_.data_ + offset)) {
+                    f((const uint32_t*)(clauses_.data_ + offset));
+                };
+            } else {
+                std::vector<uint32_t> words;
+                for (uint32_t block = begin; block < end; block++) {
+                    const uint32_t words_size = compressed_clauses_->block_words_size(block);
+                    words.resize(words_size);
+                    compressed_clauses_->decode_block(block, words.data());
+                    for (uint32_t offset = 0; offset < words_size; offset += _clause_memory_size(words.data() + offset)) {
+                        f((const uint32_t*)(words.data() + offset));
+                    };
+                };
+            };
+        };
+        
+        template<typename F>
+        void for_each_clause(F f) const {
+            for_each_clause(0, clauses_end(), f);
+        };
         
         // clause_size - 0 means count clauses of all lengths, otherwise specified length only
         // aggregated - count aggregates if true, otherwise count individual clauses
         const clauses_size_t clauses_size(const clause_size_t clause_size = 0, bool aggregated = false) const;
         const uint32_t literals_size(const bool agregated = false) const;
+        // number of clauses ignored as duplicates of existing ones, other than aggregated ones
+        const clauses_size_t duplicate_clauses_size() const { return duplicate_clauses_size_; };
+        
+        // clauses may be kept in a memory mapping or spill to a temporary file, see Container::set_memory
+        // must be set before clauses are added; returns false if the file cannot be created
+        bool set_clauses_memory(const container_memory_t& memory) {
+            assert(clauses_.size_ == 0);
+            clauses_memory_ = memory;
+            if (!clauses_.set_memory(memory)) {
+                clauses_memory_.type = cmHeap;
+                return false;
+            };
+            return true;
+        };
+        const container_memory_t& clauses_memory() const { return clauses_memory_; };
         
-        const size_t memory_size_clauses() const { return clauses_.size_ << 2; };
+        const size_t memory_size_clauses() const {
+            return is_compressed() ? compressed_clauses_->memory_size() : (size_t)clauses_.size_ << 2;
+        };
         const size_t memory_size_clauses_index() const { return l0_index_.memory_size(); };
+        // depth of the per variable clauses index trees, the deepest and the average one
+        // for the hash index, the longest and the average probe sequence
+        void get_clauses_index_depth(uint32_t& depth_max, double& depth_average) const {
+            l0_index_.get_depth_stats(depth_max, depth_average);
+        };
         
         inline VariableGenerator& variable_generator() { return variable_generator_; };
 
@@ -241,8 +359,21 @@ namespace bal {
         // returns 0 if the clause is always satisfied; otherwise returns the new size
         inline static clause_size_t normalize_clause(uint32_t* const literals, const clause_size_t literals_size) {
             assert(literals_size > 0);
+            _statistics_increment(scNormalizeClause);
+            
+            sort_short(literals, literals_size);
             
-            std::sort(literals, literals + literals_size);
+            // short clauses rarely repeat or complement a literal, check all pairs at once
+            if (literals_size <= SORTING_NETWORK_SIZE_MAX) {
+                bool is_distinct = true;
+                for (auto i = 1; i < literals_size; i++) {
+                    // the same literal or its complement, the latter follows the former when sorted
+                    is_distinct &= (literals[i] ^ literals[i - 1]) > 1;
+                };
+                if (is_distinct) {
+                    return literals_size;
+                };
+            };
             
             assert(literal_t__is_variable(literals[0]));
             clause_size_t validated_size = 1;
@@ -265,6 +396,23 @@ namespace bal {
             return validated_size;
         };
         
+        // turns a normalized clause of up to 4 literals into the aggregated form
+        // literals are uncomplemented, the header flag identifies the combination of complements
+        inline static void aggregate_clause(uint32_t* const p_clause) {
+            literalid_t* const literals = p_clause + 1;
+            const clause_size_t literals_size = *p_clause & 0xFFFF;
+            assert(literals_size <= 4 && (*p_clause & 0xFFFF0000) == 0);
+            uint16_t clause_bitmap = 0;
+            for (auto i = 0; i < literals_size; i++) {
+                if (literals[i] & 0x1) {
+                    clause_bitmap |= 0x1 << i;
+                } else {
+                    literals[i] |= 0x1;
+                };
+            };
+            *p_clause = literals_size | (0x1 << (16 + clause_bitmap));
+        };
+        
         // normalizes and ensures no duplicates by performing the following:
         //   sorts the list of literals
         //   removes any duplicates
@@ -283,6 +431,21 @@ namespace bal {
             literalid_t* const dst_literals = clauses_.data_ + clauses_.size_ + 1;
             std::copy(literals, literals + literals_size, dst_literals);
             clauses_.data_[clauses_.size_] = normalize_clause(dst_literals, literals_size);
+            // ignore the clause if it is always satisfied
+            if (clauses_.data_[clauses_.size_] != 0) {
+                l0_index_t::insertion_point_t l0_insertion_point;
+                __insertion_point_t_init(l0_insertion_point);
+                __append_clause<false>(l0_insertion_point);
+            };
+        };
+        
+        // same as append_clause for a clause normalized already with normalize_clause
+        // the header holds the clause size without flags, e.g. when prepared on another thread
+        inline void append_normalized_clause(const uint32_t* const p_clause) {
+            assert(_clause_flags(p_clause) == 0 && _clause_size(p_clause) > 0);
+            const clause_size_t literals_size = _clause_size(p_clause);
+            clauses_.reserve(literals_size + 1);
+            std::copy(p_clause, p_clause + literals_size + 1, clauses_.data_ + clauses_.size_);
             l0_index_t::insertion_point_t l0_insertion_point;
             __insertion_point_t_init(l0_insertion_point);
             __append_clause<false>(l0_insertion_point);
@@ -367,6 +530,10 @@ namespace bal {
             cnf_.__append_clause<avoid_merging>(l0_insertion_point);
         };
         
+        inline void add_duplicate_clauses_size(const clauses_size_t value) {
+            cnf_.duplicate_clauses_size_ += value;
+        };
+        
         // assume the clause is normalized
         //   i.e. literals are sorted, no duplicates etc
         template<bool avoid_merging>
@@ -382,9 +549,6 @@ namespace bal {
         
         virtual const bool execute() = 0;
     };
-    
-    void __statistics_reset();
-    void __statistics_print();
 };
 
 #endif /* cnf_hpp */
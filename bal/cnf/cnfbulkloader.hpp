@@ -0,0 +1,274 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef cnfbulkloader_hpp
+#define cnfbulkloader_hpp
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include "cnf.hpp"
+#include "parallel.hpp"
+#include "radixsort.hpp"
+#include "trace.hpp"
+
+namespace bal {
+
+    // appends many clauses at once, e.g. all clauses of a file
+    // clauses are normalized into a staging buffer as they come, with no index lookups;
+    // execute() then finds equal clauses by sorting all of them by hash, merges the aggregated
+    // ones and drops duplicates in one pass, and builds the clauses index from sorted order
+    // the result is the same as appending the clauses one by one: each clause remains where
+    // it first occurs and later occurrences are merged into it
+    class CnfBulkLoader: public CnfProcessor {
+    private:
+        const unsigned tasks_size_;
+        Container<uint32_t> staged_;
+
+        // same order as compare_clauses, which is not used here as it counts calls globally
+        static inline bool is_clause_less(const uint32_t* const lhs, const uint32_t* const rhs) {
+            const clause_size_t lhs_size = _clause_size(lhs);
+            const clause_size_t rhs_size = _clause_size(rhs);
+            const clause_size_t common_size = std::min(lhs_size, rhs_size);
+            for (clause_size_t i = 1; i <= common_size; i++) {
+                if (lhs[i] != rhs[i]) {
+                    return lhs[i] < rhs[i];
+                };
+            };
+            return lhs_size < rhs_size;
+        };
+
+        static inline bool is_clause_equal(const uint32_t* const lhs, const uint32_t* const rhs) {
+            return _clause_size(lhs) == _clause_size(rhs) &&
+                std::equal(_clause_literals(lhs), _clause_literals(lhs) + _clause_size(lhs), _clause_literals(rhs));
+        };
+
+        // keeps the first of the equal clauses, merges the headers of the others into it if aggregated
+        // returns the number of duplicates of non-aggregated clauses
+        clauses_size_t merge_clauses(const std::vector<uint32_t>& offsets, std::vector<uint8_t>& is_removed) {
+            uint32_t* const data = staged_.data_;
+            const size_t clauses_size = offsets.size();
+
+            // hash in the high half, clause number in the low one; the sort is stable so that
+            // clauses of the same hash remain in the order they occur
+            std::vector<uint64_t> keys(clauses_size);
+            parallel_for(tasks_size_, clauses_size, [&](const unsigned, const size_t begin, const size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    keys[i] = ((uint64_t)hash_clause(data + offsets[i]) << 32) | i;
+                };
+            });
+            parallel_radix_sort(tasks_size_, keys.data(), keys.size(), 32, [](const uint64_t key) { return key >> 32; });
+
+            // each task processes the hash groups starting within its range
+            std::vector<clauses_size_t> range_duplicates(tasks_size_, 0);
+            parallel_for(tasks_size_, clauses_size, [&](const unsigned index, size_t begin, size_t end) {
+                while (begin > 0 && begin < end && (keys[begin] >> 32) == (keys[begin - 1] >> 32)) {
+                    begin++;
+                };
+                while (begin < end && end < keys.size() && (keys[end] >> 32) == (keys[end - 1] >> 32)) {
+                    end++;
+                };
+                std::vector<uint32_t> group_clauses;
+                for (size_t i = begin; i < end; i++) {
+                    if (i == begin || (keys[i] >> 32) != (keys[i - 1] >> 32)) {
+                        group_clauses.clear();
+                    };
+                    const uint32_t clause_index = (uint32_t)keys[i];
+                    uint32_t* const p_clause = data + offsets[clause_index];
+                    // different clauses rarely share the hash, the group is mostly one clause
+                    auto it = std::find_if(group_clauses.begin(), group_clauses.end(), [&](const uint32_t first_index) {
+                        return is_clause_equal(data + offsets[first_index], p_clause);
+                    });
+                    if (it == group_clauses.end()) {
+                        group_clauses.push_back(clause_index);
+                    } else {
+                        if (_clause_size(p_clause) <= 4) {
+                            data[offsets[*it]] |= *p_clause;
+                        } else {
+                            range_duplicates[index]++;
+                        };
+                        is_removed[clause_index] = 1;
+                    };
+                };
+            });
+
+            clauses_size_t duplicates_size = 0;
+            for (auto value: range_duplicates) {
+                duplicates_size += value;
+            };
+            return duplicates_size;
+        };
+
+        // sorts clauses given by offsets in the low halves of keys as is_clause_less does, the clauses differ
+        // MSD radix sort by one literal at a time: clauses sharing all preceding literals are sorted
+        // by the next one, small ranges of such clauses are sorted by comparison instead
+        void sort_clauses(uint64_t* const keys, const size_t size, const unsigned literal_bits) const {
+            static const constexpr size_t RADIX_SORT_SIZE_MIN = 64;
+            typedef struct {
+                size_t begin;
+                size_t end;
+                clause_size_t literal_index;
+            } range_t;
+
+            const uint32_t* const data = clauses_.data_;
+            std::vector<range_t> ranges(1, range_t{0, size, 0});
+            while (!ranges.empty()) {
+                const range_t range = ranges.back();
+                ranges.pop_back();
+                if (range.end - range.begin < RADIX_SORT_SIZE_MIN) {
+                    std::sort(keys + range.begin, keys + range.end, [data](const uint64_t lhs, const uint64_t rhs) {
+                        return is_clause_less(data + (uint32_t)lhs, data + (uint32_t)rhs);
+                    });
+                    continue;
+                };
+                // literal id plus one, a clause ending before the literal comes first
+                const auto literal_key = [data, range](const uint64_t key) -> uint64_t {
+                    const uint32_t* const p_clause = data + (uint32_t)key;
+                    return range.literal_index < _clause_size(p_clause) ?
+                        (uint64_t)_clause_literal(p_clause, range.literal_index) + 1 : 0;
+                };
+                parallel_radix_sort(1, keys + range.begin, range.end - range.begin, literal_bits, literal_key);
+                for (size_t begin = range.begin; begin < range.end; ) {
+                    const uint64_t literal = literal_key(keys[begin]);
+                    size_t end = begin + 1;
+                    while (end < range.end && literal_key(keys[end]) == literal) {
+                        end++;
+                    };
+                    if (literal != 0 && end - begin > 1) {
+                        ranges.push_back(range_t{begin, end, (clause_size_t)(range.literal_index + 1)});
+                    };
+                    begin = end;
+                };
+            };
+        };
+
+    public:
+        // threads_size, see parallel_threads_size
+        CnfBulkLoader(Cnf& cnf, const unsigned threads_size = 1):
+            CnfProcessor(cnf), tasks_size_(parallel_threads_size(threads_size)) {
+            // the staged clauses take as much memory as the formula
+            staged_.set_memory(cnf.clauses_memory());
+        };
+
+        // same as Cnf::append_clause, though the clause takes effect on execute() only
+        inline void append_clause(const literalid_t* const literals, const clause_size_t literals_size) {
+            _statistics_increment(scStageClause);
+            staged_.reserve(literals_size + 1);
+            uint32_t* const p_clause = staged_.data_ + staged_.size_;
+            std::copy(literals, literals + literals_size, _clause_literals(p_clause));
+            *p_clause = Cnf::normalize_clause(_clause_literals(p_clause), literals_size);
+            // ignore the clause if it is always satisfied
+            if (*p_clause != 0) {
+                if (_clause_size(p_clause) <= 4) {
+                    Cnf::aggregate_clause(p_clause);
+                };
+                staged_.size_ += _clause_memory_size(p_clause);
+            };
+        };
+
+        // same as Cnf::append_normalized_clause, though the clause takes effect on execute() only
+        inline void append_normalized_clause(const uint32_t* const p_clause) {
+            assert(_clause_flags(p_clause) == 0 && _clause_size(p_clause) > 0);
+            _statistics_increment(scStageClause);
+            staged_.reserve(_clause_memory_size(p_clause));
+            uint32_t* const p_staged_clause = staged_.data_ + staged_.size_;
+            std::copy(p_clause, p_clause + _clause_memory_size(p_clause), p_staged_clause);
+            if (_clause_size(p_clause) <= 4) {
+                Cnf::aggregate_clause(p_staged_clause);
+            };
+            staged_.size_ += _clause_memory_size(p_clause);
+        };
+
+        // appends the staged clauses to the formula; the loader can be used again afterwards
+        virtual const bool execute() override {
+            assert(cnf_.get_immutable_offset() == 0);
+            TraceSpan span(stIndex, "clauses");
+            if (clauses_.size_ > 0) {
+                // the index is not empty, so the clauses are looked up one by one
+                clauses_size_t clauses_size = 0;
+                for (container_offset_t offset = 0; offset < staged_.size_; offset += _clause_memory_size(staged_.data_ + offset)) {
+                    CnfProcessor::append_clause<false>(staged_.data_ + offset);
+                    clauses_size++;
+                };
+                span.set_items(clauses_size);
+            } else {
+                std::vector<uint32_t> offsets;
+                for (container_offset_t offset = 0; offset < staged_.size_; offset += _clause_memory_size(staged_.data_ + offset)) {
+                    offsets.push_back(offset);
+                };
+                span.set_items(offsets.size());
+                std::vector<uint8_t> is_removed(offsets.size(), 0);
+                add_duplicate_clauses_size(merge_clauses(offsets, is_removed));
+
+                // clauses are kept in their order
+                clauses_.reserve(staged_.size_);
+                for (size_t i = 0; i < offsets.size(); i++) {
+                    if (!is_removed[i]) {
+                        const uint32_t* const p_clause = staged_.data_ + offsets[i];
+                        std::copy(p_clause, p_clause + _clause_memory_size(p_clause), clauses_.data_ + clauses_.size_);
+                        clauses_.size_ += _clause_memory_size(p_clause);
+                    };
+                };
+                build_index();
+            };
+            staged_.reset(0);
+            return true;
+        };
+
+        // builds the clauses index for all clauses of the formula, the index must be empty
+        // clauses are grouped by the first variable, then sorted within each group
+        void build_index() {
+            const uint32_t* const data = clauses_.data_;
+            std::vector<uint64_t> keys;
+            variableid_t variable_id_max = 0;
+            for (container_offset_t offset = 0; offset < clauses_.size_; offset += _clause_memory_size(data + offset)) {
+                const variableid_t variable_id = literal_t__variable_id(_clause_literal(data + offset, 0));
+                variable_id_max = std::max(variable_id_max, variable_id);
+                keys.push_back(((uint64_t)variable_id << 32) | offset);
+            };
+            const unsigned variable_bits = radix_sort_bits(variable_id_max);
+            // keys of sort_clauses are literal ids plus one, literal ids are below twice the variables
+            const unsigned literal_bits = radix_sort_bits((uint64_t)cnf_.variables_size() * 2);
+            parallel_radix_sort(tasks_size_, keys.data(), keys.size(), variable_bits, [](const uint64_t key) { return key >> 32; });
+
+            parallel_for(tasks_size_, keys.size(), [&](const unsigned, size_t begin, size_t end) {
+                while (begin > 0 && begin < end && (keys[begin] >> 32) == (keys[begin - 1] >> 32)) {
+                    begin++;
+                };
+                while (begin < end && end < keys.size() && (keys[end] >> 32) == (keys[end - 1] >> 32)) {
+                    end++;
+                };
+                for (size_t group_begin = begin; group_begin < end; ) {
+                    size_t group_end = group_begin + 1;
+                    while (group_end < end && (keys[group_end] >> 32) == (keys[group_begin] >> 32)) {
+                        group_end++;
+                    };
+                    sort_clauses(keys.data() + group_begin, group_end - group_begin, literal_bits);
+                    group_begin = group_end;
+                };
+            });
+
+            std::vector<container_offset_t> container_offsets;
+            for (size_t group_begin = 0; group_begin < keys.size(); ) {
+                const variableid_t variable_id = (variableid_t)(keys[group_begin] >> 32);
+                container_offsets.clear();
+                size_t group_end = group_begin;
+                while (group_end < keys.size() && (keys[group_end] >> 32) == variable_id) {
+                    container_offsets.push_back((container_offset_t)keys[group_end]);
+                    group_end++;
+                };
+                l0_index_.append_sorted(variable_id, container_offsets.data(), (container_size_t)container_offsets.size());
+                group_begin = group_end;
+            };
+        };
+
+        // number of words staged
+        container_size_t staged_size() const { return staged_.size_; };
+    };
+};
+
+#endif /* cnfbulkloader_hpp */
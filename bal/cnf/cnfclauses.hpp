@@ -9,6 +9,7 @@
 #define cnfclauses_hpp
 
 #include "container.hpp"
+#include "statistics.hpp"
 #include "variables.hpp"
 
 namespace bal {
@@ -25,12 +26,6 @@ namespace bal {
 #define _clause_header_size(header) ((header) & 0xFFFF)
 #define _clause_header_memory_size(header) (_clause_header_size(header) + 1)
     
-    extern unsigned __find_clause_found;
-    extern unsigned __find_clause_unfound;
-    extern unsigned __compare_clauses_;
-    extern unsigned __append_clause_;
-    extern unsigned __normalize_clause_;
-    
     typedef uint16_t clause_flags_t;
     typedef uint16_t clause_size_t;
     typedef uint32_t clauses_size_t;
@@ -47,7 +42,7 @@ namespace bal {
     // assume the first SAME_LITERALS are the same
     inline const int compare_clauses(const uint32_t* lhs, const uint32_t* rhs) {
         
-        __compare_clauses_++;
+        _statistics_increment(scCompareClauses);
         
         const clause_size_t lhs_size = *lhs & 0xFFFF;
         const clause_size_t rhs_size = *rhs & 0xFFFF;
@@ -65,6 +60,36 @@ namespace bal {
         return lhs_size < rhs_size ? -1 : (lhs_size == rhs_size ? 0 : 1);
     };
     
+    // hash of the clause size and literals, the same for the clauses compare_clauses finds equal
+    inline uint32_t hash_clause(const uint32_t* p_clause) {
+        const clause_size_t size = *p_clause & 0xFFFF;
+        uint64_t hash = size;
+        for (auto i = 1; i <= size; i++) {
+            hash = (hash + p_clause[i]) * 0x9E3779B97F4A7C15ull;
+            hash ^= hash >> 29;
+        };
+        return (uint32_t)(hash ^ (hash >> 32));
+    };
+    
+    
+    // splits the clauses buffer into ranges_size consecutive ranges of about the same memory size
+    // range i starts at offsets[i] with the clause number first_clauses[i]; both have ranges_size + 1 items
+    // returns the number of clauses
+    inline clauses_size_t split_clauses(const uint32_t* const data, const uint32_t data_size, const unsigned ranges_size,
+                                        uint32_t* const offsets, clauses_size_t* const first_clauses) {
+        clauses_size_t clauses_size = 0;
+        uint32_t offset = 0;
+        for (unsigned i = 0; i <= ranges_size; i++) {
+            const uint64_t range_offset = (uint64_t)data_size * i / ranges_size;
+            while (offset < range_offset) {
+                offset += _clause_memory_size(data + offset);
+                clauses_size++;
+            };
+            offsets[i] = offset;
+            first_clauses[i] = clauses_size;
+        };
+        return clauses_size;
+    };
     
     inline uint16_t get_cardinality_uint16(const uint16_t value) {
         // 0  1  2  3  4  5  6  7  8  9  a  b  c  d  e  f
@@ -72,6 +97,12 @@ namespace bal {
         return map[value & 0xF] + map[value >> 4 & 0xF] +
         map[value >> 8 & 0xF] + map[value >> 12 & 0xF];
     };
+    
+    // number of clauses represented by a clause with the given header
+    // a clause of up to 4 literals aggregates all clauses over the same variables, one per flag
+    inline uint16_t get_clause_header_cardinality(const uint32_t header) {
+        return _clause_header_size(header) <= 4 ? get_cardinality_uint16(_clause_header_flags(header)) : 1;
+    };
 };
 
 #endif /* cnfclauses_hpp */
@@ -0,0 +1,132 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef cnfcompressed_hpp
+#define cnfcompressed_hpp
+
+#include <stdint.h>
+#include <vector>
+#include "cnfclauses.hpp"
+#include "streamvbyte.hpp"
+
+namespace bal {
+
+    // clauses in the Cnf layout, compressed in blocks of BLOCK_CLAUSES clauses
+    // each clause is a sequence of values encoded with Stream VByte:
+    //   the header, with the flags of an aggregated clause moved next to its size, see encode_header
+    //   the first literal as the difference from the first literal of the previous clause,
+    //   zigzag encoded; neighbouring clauses tend to share variables
+    //   differences between the subsequent literals, small since literals are sorted
+    // blocks are decoded independently, e.g. on different threads
+    class CnfCompressedClauses {
+    public:
+        static const constexpr uint32_t BLOCK_CLAUSES = 256;
+
+    private:
+        typedef struct {
+            // offsets of the block in control_ and data_
+            size_t control_offset;
+            size_t data_offset;
+            // number of values encoded, i.e. the size of the decoded block in words
+            uint32_t words_size;
+        } block_t;
+
+        std::vector<block_t> blocks_;
+        std::vector<uint8_t> control_;
+        std::vector<uint8_t> data_;
+        uint32_t words_size_ = 0;
+        clauses_size_t clauses_size_ = 0;
+
+        // size in the lowest 3 bits for clauses of up to 4 literals, the other ones have no flags
+        static inline uint32_t encode_header(const uint32_t header) {
+            const uint32_t size = _clause_header_size(header);
+            return size <= 4 ? (_clause_header_flags(header) << 3) | size : size << 3;
+        };
+
+        static inline uint32_t decode_header(const uint32_t value) {
+            return (value & 7) != 0 ? ((value >> 3) << 16) | (value & 7) : value >> 3;
+        };
+
+        static inline uint32_t zigzag_encode(const int32_t value) {
+            return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+        };
+
+        static inline int32_t zigzag_decode(const uint32_t value) {
+            return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+        };
+
+    public:
+        // data is a sequence of clauses in the Cnf layout
+        void encode(const uint32_t* const data, const uint32_t data_size) {
+            blocks_.clear();
+            control_.clear();
+            data_.clear();
+            words_size_ = data_size;
+            clauses_size_ = 0;
+
+            std::vector<uint32_t> values;
+            uint32_t offset = 0;
+            while (offset < data_size) {
+                // transform the clauses of the block, the first literal of the first clause is as is
+                values.clear();
+                literalid_t previous_literal = 0;
+                for (uint32_t i = 0; i < BLOCK_CLAUSES && offset < data_size; i++, clauses_size_++) {
+                    const uint32_t* const p_clause = data + offset;
+                    const clause_size_t clause_size = _clause_size(p_clause);
+                    values.push_back(encode_header(*p_clause));
+                    values.push_back(zigzag_encode((int32_t)(_clause_literal(p_clause, 0) - previous_literal)));
+                    for (clause_size_t j = 1; j < clause_size; j++) {
+                        values.push_back(_clause_literal(p_clause, j) - _clause_literal(p_clause, j - 1));
+                    };
+                    previous_literal = _clause_literal(p_clause, 0);
+                    offset += _clause_memory_size(p_clause);
+                };
+
+                const block_t block = {control_.size(), data_.size(), (uint32_t)values.size()};
+                blocks_.push_back(block);
+                control_.resize(block.control_offset + stream_vbyte_control_size(values.size()));
+                data_.resize(block.data_offset + stream_vbyte_data_size_max(values.size()));
+                const size_t data_size = stream_vbyte_encode(values.data(), values.size(),
+                                                             control_.data() + block.control_offset, data_.data() + block.data_offset);
+                data_.resize(block.data_offset + data_size);
+            };
+            data_.resize(data_.size() + STREAM_VBYTE_PADDING, 0);
+            control_.shrink_to_fit();
+            data_.shrink_to_fit();
+        };
+
+        // decodes the block into words in the Cnf layout; words must have room for block_words_size(block)
+        void decode_block(const uint32_t block, uint32_t* const words) const {
+            const block_t& b = blocks_[block];
+            stream_vbyte_decode(control_.data() + b.control_offset, data_.data() + b.data_offset, b.words_size, words);
+            literalid_t previous_literal = 0;
+            for (uint32_t offset = 0; offset < b.words_size; ) {
+                uint32_t* const p_clause = words + offset;
+                *p_clause = decode_header(*p_clause);
+                const clause_size_t clause_size = _clause_size(p_clause);
+                p_clause[1] = previous_literal + zigzag_decode(p_clause[1]);
+                previous_literal = p_clause[1];
+                for (clause_size_t j = 2; j <= clause_size; j++) {
+                    p_clause[j] += p_clause[j - 1];
+                };
+                offset += clause_size + 1;
+            };
+        };
+
+        uint32_t blocks_size() const { return (uint32_t)blocks_.size(); };
+        uint32_t block_words_size(const uint32_t block) const { return blocks_[block].words_size; };
+        clauses_size_t clauses_size() const { return clauses_size_; };
+        // size of the decoded clauses in words
+        uint32_t words_size() const { return words_size_; };
+
+        size_t memory_size() const {
+            return blocks_.size() * sizeof(block_t) + control_.size() + data_.size();
+        };
+    };
+};
+
+#endif /* cnfcompressed_hpp */
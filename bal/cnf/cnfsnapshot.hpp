@@ -0,0 +1,381 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef cnfsnapshot_hpp
+#define cnfsnapshot_hpp
+
+#include <stdint.h>
+#include <string.h>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "streamable.hpp"
+#include "mappedfile.hpp"
+#include "cnf.hpp"
+#include "cnfbulkloader.hpp"
+
+namespace bal {
+
+    // binary image of a Cnf, loaded by mapping the file into memory with no parsing or copying
+    // the file starts with the header followed by the sections at the positions it gives,
+    // each aligned to 8 bytes:
+    //   clauses - uint32_t[clauses_words], Cnf clauses as they are stored
+    //   index items - the clauses index items, index_item_size bytes each
+    //   index instances - uint32_t[index_instances_size], the first item for each variable
+    //   metadata - named variables then parameters, see CnfSnapshotStreamWriter::write_metadata
+    // values are in the byte order of the host that wrote the file, byte_order tells which
+    static const constexpr char CNF_SNAPSHOT_MAGIC[8] = {'C', 'G', 'R', 'A', 'P', 'H', 'S', 'N'};
+    static const constexpr uint32_t CNF_SNAPSHOT_VERSION = 1;
+    static const constexpr uint32_t CNF_SNAPSHOT_BYTE_ORDER = 0x01020304;
+    // the index is CnfHashIndex rather than CnfL0Index
+    static const constexpr uint32_t CNF_SNAPSHOT_FLAG_HASH_INDEX = 1;
+
+    typedef struct {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint32_t flags;
+        uint32_t index_item_size;
+        uint32_t variables_size;
+        uint32_t clauses_words;
+        uint32_t index_items_size;
+        uint32_t index_instances_size;
+        uint32_t immutable_offset;
+        uint32_t duplicate_clauses_size;
+        uint32_t add_max_args;
+        uint32_t xor_max_args;
+        uint32_t add_naive;
+        uint32_t reserved0;
+        uint64_t clauses_position;
+        uint64_t index_items_position;
+        uint64_t index_instances_position;
+        uint64_t metadata_position;
+        uint64_t metadata_size;
+        uint64_t reserved[3];
+    } cnf_snapshot_header_t;
+
+    static_assert(sizeof(cnf_snapshot_header_t) == 128, "cnf_snapshot_header_t must have no padding");
+
+    static const constexpr uint32_t CNF_SNAPSHOT_FLAGS = std::is_same<Cnf::l0_index_t, CnfHashIndex>::value ?
+        CNF_SNAPSHOT_FLAG_HASH_INDEX : 0;
+
+    // true if the content starts with the snapshot magic
+    inline bool is_cnf_snapshot(const char* const data, const size_t size) {
+        return size >= sizeof(CNF_SNAPSHOT_MAGIC) && memcmp(data, CNF_SNAPSHOT_MAGIC, sizeof(CNF_SNAPSHOT_MAGIC)) == 0;
+    };
+
+    inline bool is_cnf_snapshot_file(const char* const file_name) {
+        char prefix[sizeof(CNF_SNAPSHOT_MAGIC)];
+        std::ifstream file(file_name, std::ios::in | std::ios::binary);
+        return file.read(prefix, sizeof(prefix)) && is_cnf_snapshot(prefix, sizeof(prefix));
+    };
+
+    class CnfSnapshotStreamWriter: public StreamWriter<Cnf> {
+    private:
+        uint64_t position_ = 0;
+
+        static inline uint64_t align(const uint64_t position) {
+            return (position + 7) & ~(uint64_t)7;
+        };
+
+        inline void write_data(const void* const data, const size_t size) {
+            stream().write((const char*)data, size);
+            position_ += size;
+        };
+
+        inline void write_uint32(const uint32_t value) {
+            write_data(&value, sizeof(value));
+        };
+
+        inline void write_string(const std::string& value) {
+            write_uint32((uint32_t)value.size());
+            write_data(value.data(), value.size());
+        };
+
+        inline void write_padding() {
+            static const char padding[8] = {0};
+            write_data(padding, align(position_) - position_);
+        };
+
+        // named variables: count, then name, size, element size and literals of each
+        // parameters: count, then key and value of each; strings are preceded by their size
+        void write_metadata(const Cnf& value) {
+            const formula_named_variables_t& named_variables = value.get_named_variables();
+            write_uint32((uint32_t)named_variables.size());
+            for (const auto& item: named_variables) {
+                write_string(item.first);
+                write_uint32(item.second.size());
+                write_uint32(item.second.element_size());
+                write_data(item.second.data(), item.second.size() * sizeof(literalid_t));
+            };
+            const formula_parameters_t& parameters = value.get_parameters();
+            write_uint32((uint32_t)parameters.size());
+            for (const auto& item: parameters) {
+                write_string(item.first);
+                write_string(item.second);
+            };
+        };
+
+    public:
+        CnfSnapshotStreamWriter(std::ostream& stream): StreamWriter<Cnf>(stream) {};
+
+        // the clauses must not be compressed
+        virtual void write(const Cnf& value) override {
+            assert(!value.is_compressed());
+            const auto& items = value.l0_index_.items();
+            const auto& instances = value.l0_index_.instances();
+
+            cnf_snapshot_header_t header = {};
+            memcpy(header.magic, CNF_SNAPSHOT_MAGIC, sizeof(CNF_SNAPSHOT_MAGIC));
+            header.version = CNF_SNAPSHOT_VERSION;
+            header.byte_order = CNF_SNAPSHOT_BYTE_ORDER;
+            header.flags = CNF_SNAPSHOT_FLAGS;
+            header.index_item_size = sizeof(Cnf::l0_index_t::index_data_t);
+            header.variables_size = value.variables_size();
+            header.clauses_words = value.clauses_.size_;
+            header.index_items_size = items.size_;
+            header.index_instances_size = instances.size_;
+            header.immutable_offset = value.immutable_offset_;
+            header.duplicate_clauses_size = value.duplicate_clauses_size_;
+            header.add_max_args = value.add_max_args_;
+            header.xor_max_args = value.xor_max_args_;
+            header.add_naive = value.add_naive_ ? 1 : 0;
+            header.clauses_position = align(sizeof(cnf_snapshot_header_t));
+            header.index_items_position = align(header.clauses_position + (uint64_t)header.clauses_words * sizeof(uint32_t));
+            header.index_instances_position = align(header.index_items_position + (uint64_t)header.index_items_size * header.index_item_size);
+            header.metadata_position = align(header.index_instances_position + (uint64_t)header.index_instances_size * sizeof(container_offset_t));
+
+            position_ = 0;
+            write_data(&header, sizeof(header));
+            write_padding();
+            write_data(value.clauses_.data_, (size_t)header.clauses_words * sizeof(uint32_t));
+            write_padding();
+            write_data(items.data_, (size_t)header.index_items_size * header.index_item_size);
+            write_padding();
+            write_data(instances.data_, (size_t)header.index_instances_size * sizeof(container_offset_t));
+            write_padding();
+            write_metadata(value);
+
+            // the size of the metadata is known once it is written
+            header.metadata_size = position_ - header.metadata_position;
+            stream().seekp(0);
+            stream().write((const char*)&header, sizeof(header));
+            stream().seekp(0, std::ios::end);
+            stream().flush();
+        };
+    };
+
+    // maps the snapshot and attaches the formula to it; the formula keeps the mapping
+    // modifying the formula afterwards copies what changes to the heap, the file remains as is
+    // the index is rebuilt if the snapshot comes from a build with the other clauses index
+    class CnfSnapshotReader {
+    private:
+        std::string error_;
+        const char* metadata_ = nullptr;
+        const char* metadata_end_ = nullptr;
+
+        bool read_data(void* const data, const size_t size) {
+            if ((size_t)(metadata_end_ - metadata_) < size) {
+                return false;
+            };
+            memcpy(data, metadata_, size);
+            metadata_ += size;
+            return true;
+        };
+
+        bool read_uint32(uint32_t& value) {
+            return read_data(&value, sizeof(value));
+        };
+
+        bool read_string(std::string& value) {
+            uint32_t size = 0;
+            if (!read_uint32(size) || (size_t)(metadata_end_ - metadata_) < size) {
+                return false;
+            };
+            value.assign(metadata_, size);
+            metadata_ += size;
+            return true;
+        };
+
+        bool read_metadata(Cnf& cnf) {
+            uint32_t named_variables_size = 0;
+            if (!read_uint32(named_variables_size)) {
+                return false;
+            };
+            for (uint32_t i = 0; i < named_variables_size; i++) {
+                std::string name;
+                uint32_t size = 0;
+                uint32_t element_size = 0;
+                if (!read_string(name) || !read_uint32(size) || !read_uint32(element_size) ||
+                    element_size == 0 || element_size > size || size % element_size != 0 ||
+                    (size_t)(metadata_end_ - metadata_) / sizeof(literalid_t) < size) {
+                    return false;
+                };
+                VariablesArray value(size / element_size, element_size);
+                read_data(value.data(), size * sizeof(literalid_t));
+                cnf.add_named_variable(name.c_str(), value);
+            };
+            uint32_t parameters_size = 0;
+            if (!read_uint32(parameters_size)) {
+                return false;
+            };
+            for (uint32_t i = 0; i < parameters_size; i++) {
+                std::string key;
+                std::string value;
+                if (!read_string(key) || !read_string(value)) {
+                    return false;
+                };
+                cnf.get_parameters_()[key] = value;
+            };
+            return true;
+        };
+
+        static bool is_section_valid(const uint64_t position, const uint64_t size, const uint64_t item_size, const size_t file_size) {
+            return position % 8 == 0 && position <= file_size && size <= (file_size - position) / item_size;
+        };
+
+        static inline bool is_item_offset_valid(const container_offset_t offset, const uint32_t items_size) {
+            return offset == CONTAINER_END || offset < items_size;
+        };
+
+        static bool is_index_item_valid(const avl_tree_index_item_t& item, const uint32_t items_size) {
+            return is_item_offset_valid(item.parent_offset, items_size) && is_item_offset_valid(item.left_offset, items_size) &&
+                is_item_offset_valid(item.right_offset, items_size);
+        };
+
+        static bool is_index_item_valid(const hash_index_item_t& item, const uint32_t items_size) {
+            return is_item_offset_valid(item.next_offset, items_size);
+        };
+
+        // walks the clauses once, each clause must fit the section and refer to the variables of the header
+        // clause_starts receives the offset of each clause
+        static bool is_clauses_valid(const uint32_t* const clauses, const cnf_snapshot_header_t& header, std::vector<bool>& clause_starts) {
+            clause_starts.assign(header.clauses_words, false);
+            uint32_t offset = 0;
+            while (offset < header.clauses_words) {
+                const uint32_t* const p_clause = clauses + offset;
+                const clause_size_t clause_size = _clause_size(p_clause);
+                if (clause_size == 0 || clause_size >= header.clauses_words - offset) {
+                    return false;
+                };
+                for (clause_size_t i = 0; i < clause_size; i++) {
+                    if (literal_t__variable_id(_clause_literal(p_clause, i)) >= header.variables_size) {
+                        return false;
+                    };
+                };
+                clause_starts[offset] = true;
+                offset += _clause_memory_size(p_clause);
+            };
+            return header.immutable_offset <= header.clauses_words;
+        };
+
+        // items must refer to clauses and other items, instances to items
+        template<typename INDEX_ITEM_T>
+        static bool is_index_valid(const INDEX_ITEM_T* const items, const container_offset_t* const instances,
+                                   const cnf_snapshot_header_t& header, const std::vector<bool>& clause_starts) {
+            for (uint32_t i = 0; i < header.index_items_size; i++) {
+                if (items[i].container_offset >= header.clauses_words || !clause_starts[items[i].container_offset] ||
+                    !is_index_item_valid(items[i], header.index_items_size)) {
+                    return false;
+                };
+            };
+            for (uint32_t i = 0; i < header.index_instances_size; i++) {
+                if (!is_item_offset_valid(instances[i], header.index_items_size)) {
+                    return false;
+                };
+            };
+            return true;
+        };
+
+        // the index is checked whether or not this build uses it, its layout is given by the header
+        static bool is_stored_index_valid(const char* const items, const container_offset_t* const instances,
+                                          const cnf_snapshot_header_t& header, const std::vector<bool>& clause_starts) {
+            if (header.flags == CNF_SNAPSHOT_FLAG_HASH_INDEX && header.index_item_size == sizeof(hash_index_item_t)) {
+                return is_index_valid((const hash_index_item_t*)items, instances, header, clause_starts);
+            };
+            if (header.flags == 0 && header.index_item_size == sizeof(avl_tree_index_item_t)) {
+                return is_index_valid((const avl_tree_index_item_t*)items, instances, header, clause_starts);
+            };
+            return false;
+        };
+
+    public:
+        // returns false and sets error() if the file cannot be used
+        // the content is checked before use, so that a corrupted file is rejected rather than read out of bounds
+        bool read(Cnf& cnf, const char* const file_name) {
+            error_.clear();
+            std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+            if (!file->open(file_name, true)) {
+                error_ = "cannot map the file";
+                return false;
+            };
+
+            cnf_snapshot_header_t header;
+            if (file->size() < sizeof(header) || !is_cnf_snapshot(file->data(), file->size())) {
+                error_ = "not a snapshot";
+                return false;
+            };
+            memcpy(&header, file->data(), sizeof(header));
+            if (header.byte_order != CNF_SNAPSHOT_BYTE_ORDER) {
+                error_ = "the snapshot comes from a host with the other byte order";
+                return false;
+            };
+            if (header.version != CNF_SNAPSHOT_VERSION) {
+                error_ = "unsupported snapshot version " + std::to_string(header.version);
+                return false;
+            };
+            if (!is_section_valid(header.clauses_position, header.clauses_words, sizeof(uint32_t), file->size()) ||
+                !is_section_valid(header.index_items_position, header.index_items_size, std::max(header.index_item_size, 1u), file->size()) ||
+                !is_section_valid(header.index_instances_position, header.index_instances_size, sizeof(container_offset_t), file->size()) ||
+                !is_section_valid(header.metadata_position, header.metadata_size, 1, file->size())) {
+                error_ = "the snapshot is truncated or corrupted";
+                return false;
+            };
+
+            char* const data = file->data();
+            uint32_t* const clauses = (uint32_t*)(data + header.clauses_position);
+            Cnf::l0_index_t::index_data_t* const items = (Cnf::l0_index_t::index_data_t*)(data + header.index_items_position);
+            container_offset_t* const instances = (container_offset_t*)(data + header.index_instances_position);
+            const bool is_index_used = header.flags == CNF_SNAPSHOT_FLAGS && header.index_item_size == sizeof(Cnf::l0_index_t::index_data_t);
+            std::vector<bool> clause_starts;
+            if (!is_clauses_valid(clauses, header, clause_starts) ||
+                !is_stored_index_valid(data + header.index_items_position, instances, header, clause_starts)) {
+                error_ = "the snapshot is corrupted";
+                return false;
+            };
+
+            cnf.initialize(header.variables_size, 0);
+            cnf.clauses_.attach(clauses, header.clauses_words);
+            if (is_index_used) {
+                cnf.l0_index_.attach(items, header.index_items_size, instances, header.index_instances_size);
+            } else {
+                CnfBulkLoader(cnf).build_index();
+            };
+            cnf.immutable_offset_ = header.immutable_offset;
+            cnf.duplicate_clauses_size_ = header.duplicate_clauses_size;
+            cnf.add_max_args_ = header.add_max_args;
+            cnf.xor_max_args_ = header.xor_max_args;
+            cnf.add_naive_ = header.add_naive != 0;
+            cnf.external_data_ = file;
+
+            metadata_ = data + header.metadata_position;
+            metadata_end_ = metadata_ + header.metadata_size;
+            if (!read_metadata(cnf)) {
+                cnf.initialize(0, 0);
+                error_ = "the snapshot metadata is corrupted";
+                return false;
+            };
+            return true;
+        };
+
+        const std::string& error() const { return error_; };
+    };
+};
+
+#endif /* cnfsnapshot_hpp */
@@ -0,0 +1,125 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef csr_hpp
+#define csr_hpp
+
+#include <stdint.h>
+#include <algorithm>
+#include "streamable.hpp"
+#include "variableincidencegraph.hpp"
+#include "cnf.hpp"
+
+namespace bal {
+
+    // binary variable incidence graph in CSR form, meant to be memory mapped as is
+    // all values are little-endian; the file starts with the header followed by the arrays
+    // each array starts at the position given in the header, aligned to 8 bytes:
+    //   offsets - uint64_t[nodes_size + 1], the row of node i is [offsets[i], offsets[i + 1])
+    //   targets - uint32_t[entries_size], node IDs sorted ascending within each row
+    //   weights - double[entries_size], only if CSR_FLAG_WEIGHTS is set
+    // node i corresponds to DIMACS variable i + 1; each undirected edge is present
+    // in the rows of both its nodes, so entries_size is twice the number of edges
+    static const constexpr char CSR_MAGIC[8] = {'C', 'G', 'R', 'A', 'P', 'H', 'C', 'S'};
+    static const constexpr uint32_t CSR_VERSION = 1;
+    static const constexpr uint32_t CSR_FLAG_WEIGHTS = 1;
+
+    typedef struct {
+        char magic[8];
+        uint32_t version;
+        uint32_t flags;
+        uint64_t nodes_size;
+        uint64_t entries_size;
+        uint64_t offsets_position;
+        uint64_t targets_position;
+        uint64_t weights_position;
+        uint64_t reserved;
+    } csr_header_t;
+
+    static_assert(sizeof(csr_header_t) == 64, "csr_header_t must have no padding");
+
+    // weights are the same as GraphMLWeightedStreamWriter writes
+    class CsrStreamWriter: public StreamWriter<Cnf> {
+    private:
+        const bool is_weighted_;
+        const unsigned threads_size_;
+        uint64_t position_ = 0;
+
+        static inline uint64_t align(const uint64_t position) {
+            return (position + 7) & ~(uint64_t)7;
+        };
+
+        // values are written byte by byte reversed on big-endian hosts
+        template<typename T>
+        void write_array(const T* const data, const size_t size) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            char buffer[1 << 16];
+            const size_t buffer_values_size = sizeof(buffer) / sizeof(T);
+            for (size_t i = 0; i < size; i += buffer_values_size) {
+                const size_t values_size = std::min(buffer_values_size, size - i);
+                const char* const values = (const char*)(data + i);
+                for (size_t j = 0; j < values_size * sizeof(T); j++) {
+                    buffer[j] = values[(j / sizeof(T)) * sizeof(T) + sizeof(T) - 1 - j % sizeof(T)];
+                };
+                stream().write(buffer, values_size * sizeof(T));
+            };
+#else
+            stream().write((const char*)data, size * sizeof(T));
+#endif
+            position_ += size * sizeof(T);
+        };
+
+        void write_padding() {
+            static const char padding[8] = {0};
+            stream().write(padding, align(position_) - position_);
+            position_ = align(position_);
+        };
+
+    public:
+        // threads_size, see parallel_threads_size
+        CsrStreamWriter(std::ostream& stream, const bool is_weighted = false, const unsigned threads_size = 1):
+            StreamWriter<Cnf>(stream), is_weighted_(is_weighted), threads_size_(threads_size) {};
+
+        virtual void write(const Cnf& value) override {
+            const VariableIncidenceGraph graph(value, threads_size_);
+
+            csr_header_t header = {};
+            std::copy(CSR_MAGIC, CSR_MAGIC + sizeof(CSR_MAGIC), header.magic);
+            header.version = CSR_VERSION;
+            header.flags = is_weighted_ ? CSR_FLAG_WEIGHTS : 0;
+            header.nodes_size = graph.nodes_size();
+            header.entries_size = graph.neighbours().size();
+            header.offsets_position = align(sizeof(csr_header_t));
+            header.targets_position = align(header.offsets_position + (header.nodes_size + 1) * sizeof(uint64_t));
+            header.weights_position = is_weighted_ ? align(header.targets_position + header.entries_size * sizeof(uint32_t)) : 0;
+
+            position_ = 0;
+            write_array(header.magic, sizeof(header.magic));
+            write_array(&header.version, 1);
+            write_array(&header.flags, 1);
+            write_array(&header.nodes_size, 1);
+            write_array(&header.entries_size, 1);
+            write_array(&header.offsets_position, 1);
+            write_array(&header.targets_position, 1);
+            write_array(&header.weights_position, 1);
+            write_array(&header.reserved, 1);
+
+            write_padding();
+            write_array(graph.offsets().data(), graph.offsets().size());
+            write_padding();
+            write_array(graph.neighbours().data(), graph.neighbours().size());
+            if (is_weighted_) {
+                write_padding();
+                write_array(graph.weights().data(), graph.weights().size());
+            };
+            stream().flush();
+        };
+    };
+
+};
+
+#endif /* csr_hpp */
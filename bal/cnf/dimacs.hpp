@@ -8,16 +8,52 @@
 #ifndef dimacs_hpp
 #define dimacs_hpp
 
+#include <exception>
+#include <memory>
+#include <string.h>
 #include "streamable.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
 #include "cnf.hpp"
+#include "cnfbulkloader.hpp"
 #include "variablesio.hpp"
 
 namespace bal {
     
     class DimacsStreamReader:
-        private virtual TextStreamReader<Cnf>,
+        protected virtual TextStreamReader<Cnf>,
         private virtual VariableTextReader {
             
+    private:
+        // clauses section is parsed in parallel for buffered input only
+        // with at least this many bytes per thread
+        static const size_t constexpr PARALLEL_CHUNK_SIZE_MIN = 1 << 16;
+        
+        // comment line deferred while parsing a chunk, processed on the calling thread
+        typedef struct {
+            const char* data;
+            size_t size;
+            size_t line_index; // relative to the chunk
+            container_size_t clauses_offset; // clauses of the chunk preceding the line
+        } comment_line_t;
+        
+        // part of the clauses section parsed by a single thread
+        // clauses are normalized, the header is the clause size without flags
+        struct chunk_t {
+            const char* begin = nullptr;
+            const char* end = nullptr;
+            Container<uint32_t> clauses;
+            std::vector<comment_line_t> comment_lines;
+            size_t lines_size = 0;
+            std::exception_ptr exception;
+        };
+        
+        unsigned threads_size_;
+        // clauses read so far, for reporting progress
+        clauses_size_t clauses_read_ = 0;
+        // clauses are loaded in bulk once all of them are read
+        std::unique_ptr<CnfBulkLoader> loader_;
+        
     private:
         void read_header(Cnf& cnf) {
             read_token("p");
@@ -29,7 +65,7 @@ namespace bal {
             clauses_size_t clauses_size = read_uint32();
             skip_space();
             read_eol();
-            cnf.initialize(variables_size, clauses_size);
+            initialize(cnf, variables_size, clauses_size);
         };
             
         void read_parameter(Cnf& cnf, const std::string key) {
@@ -77,58 +113,247 @@ namespace bal {
             cnf.add_named_variable(name.data(), value);
         };
         
-    public:
-        DimacsStreamReader(std::istream& stream): TextStreamReader<Cnf>(stream) {};
-        
-        virtual void read(Cnf& value) override {
-            bool is_header_read = false;
-            std::vector<literalid_t> literals;
-            
-            while (!is_eof()) {
-                if (is_symbol('c')) {
+        void read_comment(Cnf& cnf) {
+            read_symbol('c');
+            skip_space();
+            if (is_token("var")) {
+                skip_token();
+                skip_space();
+                if (is_symbol('.')) {
                     skip_symbol();
+                    read_parameters(cnf);
+                } else if (is_token(ttLiteral)) {
+                    read_named_variable(cnf);
+                } else {
+                    skip_line();
+                };
+            } else {
+                skip_line();
+            };
+        };
+        
+        void read_clause(std::vector<literalid_t>& literals) {
+            literals.clear();
+            const bool is_terminated = read_sint32_sequence(literals);
+            for (auto& literal: literals) {
+                literal = literal_t::signed_encode((int32_t)literal);
+            };
+            // the rest of the clause, if any, is read token by token
+            if (!is_terminated) {
+                while (!is_eol()) {
                     skip_space();
-                    if (is_token("var")) {
-                        skip_token();
+                    if (is_symbol('0')) {
+                        break;
+                    }
+                    else {
+                        literals.push_back(literal_t::signed_encode(read_sint32()));
+                    }
+                };
+                skip_space();
+                read_symbol('0');
+            };
+            skip_space();
+            read_eol();
+            
+            assert(literals.size() <= CLAUSE_SIZE_MAX);
+        };
+        
+        // executed on a worker thread, reads the whole buffer as a part of the clauses section
+        // "c var" lines are recorded to be processed later, other comments are ignored
+        void read_chunk(chunk_t& chunk) {
+            std::vector<literalid_t> literals;
+            chunk.clauses.reset((container_size_t)((chunk.end - chunk.begin) >> 2));
+            try {
+                while (!is_eof()) {
+                    if (is_symbol('c')) {
+                        const comment_line_t comment_line = {
+                            get_current_line_data(), get_current_line_size(), get_current_line_index(),
+                            chunk.clauses.size_
+                        };
+                        skip_symbol();
                         skip_space();
-                        if (is_symbol('.')) {
-                            skip_symbol();
-                            read_parameters(value);
-                        } else if (is_token(ttLiteral)) {
-                            read_named_variable(value);
-                        } else {
-                            skip_line();
+                        if (is_token("var")) {
+                            chunk.comment_lines.push_back(comment_line);
                         };
-                    } else {
                         skip_line();
+                    } else {
+                        read_clause(literals);
+                        chunk.clauses.reserve((container_size_t)literals.size() + 1);
+                        uint32_t* const p_clause = chunk.clauses.data_ + chunk.clauses.size_;
+                        std::copy(literals.begin(), literals.end(), _clause_literals(p_clause));
+                        *p_clause = Cnf::normalize_clause(_clause_literals(p_clause), literals.size());
+                        // clauses which are always satisfied are ignored
+                        if (*p_clause != 0) {
+                            chunk.clauses.size_ += _clause_memory_size(p_clause);
+                        };
                     };
-                } else if (is_symbol('p')) {
-                    assert(!is_header_read);
-                    read_header(value);
-                    is_header_read = true;
-                } else {
-                    assert(is_header_read);
-                    literals.clear();
-                    while (!is_eol()) {
-                        skip_space();
-                        if (is_symbol('0')) {
-                            break;
-                        }
-                        else {
-                            literals.push_back(literal_t::signed_encode(read_sint32()));
+                };
+                read_eof();
+            }
+            catch (...) {
+                chunk.exception = std::current_exception();
+            };
+            chunk.lines_size = get_current_line_index();
+        };
+        
+        // splits the rest of the buffer starting from the current line into chunks,
+        // parses them in parallel and appends the clauses in their original order
+        // does nothing if the buffer is too small to split
+        void read_clauses_parallel(Cnf& cnf) {
+            const char* const begin = get_current_line_data();
+            const char* const end = get_buffer_end();
+            const size_t chunks_size = std::min<size_t>(threads_size_, (end - begin) / PARALLEL_CHUNK_SIZE_MIN);
+            if (chunks_size <= 1) {
+                return;
+            };
+            
+            // each clause is expected on its own line terminated with 0
+            // so chunks are aligned to the line boundaries
+            std::vector<chunk_t> chunks(chunks_size);
+            const char* chunk_begin = begin;
+            for (size_t i = 0; i < chunks_size; i++) {
+                const char* chunk_end = begin + (end - begin) * (i + 1) / chunks_size;
+                if (chunk_end < chunk_begin) {
+                    chunk_end = chunk_begin;
+                };
+                if (chunk_end < end && chunk_end > begin && *(chunk_end - 1) != '\n') {
+                    const char* const eol = (const char*)memchr(chunk_end, '\n', end - chunk_end);
+                    chunk_end = eol == nullptr ? end : eol + 1;
+                };
+                chunks[i].begin = chunk_begin;
+                chunks[i].end = chunk_end;
+                chunk_begin = chunk_end;
+            };
+            
+            parallel_execute((unsigned)chunks_size, [&](const unsigned index) {
+                chunk_t& chunk = chunks[index];
+                DimacsStreamReader chunk_reader(stream(), chunk.begin, chunk.end - chunk.begin);
+                chunk_reader.read_chunk(chunk);
+            });
+            
+            // line index of the first line of the chunk minus one
+            size_t line_index_offset = get_current_line_index() - 1;
+            for (auto& chunk: chunks) {
+                const uint32_t* p_clause = chunk.clauses.data_;
+                const uint32_t* const p_clauses_end = chunk.clauses.data_ + chunk.clauses.size_;
+                // appends clauses up to the given one
+                const auto append_clauses = [&](const uint32_t* const p_end) {
+                    while (p_clause < p_end) {
+                        append_normalized_clause(cnf, p_clause);
+                        p_clause += _clause_memory_size(p_clause);
+                        clauses_read_++;
+                    };
+                };
+                
+                try {
+                    // comments and clauses take effect in their original order, as they do when reading
+                    // sequentially, so that nothing following an error is loaded
+                    for (auto& comment_line: chunk.comment_lines) {
+                        append_clauses(chunk.clauses.data_ + comment_line.clauses_offset);
+                        DimacsStreamReader comment_reader(stream(), comment_line.data, comment_line.size);
+                        try {
+                            comment_reader.read_comment(cnf);
                         }
+                        catch (TextReaderException& e) {
+                            e.add_line_index_offset(comment_line.line_index - 1);
+                            throw;
+                        };
+                    };
+                    append_clauses(p_clauses_end);
+                    if (chunk.exception) {
+                        std::rethrow_exception(chunk.exception);
                     };
-                    skip_space();
-                    read_symbol('0');
-                    skip_space();
-                    read_eol();
-                    
-                    assert(literals.size() <= CLAUSE_SIZE_MAX);
-                    value.append_clause(literals.data(), literals.size());
                 }
+                catch (TextReaderException& e) {
+                    e.add_line_index_offset(line_index_offset);
+                    throw;
+                };
+                
+                line_index_offset += chunk.lines_size;
+            };
+            
+            skip_buffer();
+        };
+        
+    protected:
+        // the below define how the formula is populated
+        // descendants may redirect the clauses elsewhere, e.g. to process them as they are read
+        virtual void initialize(Cnf& cnf, const variables_size_t variables_size, const clauses_size_t clauses_size) {
+            cnf.initialize(variables_size, clauses_size);
+            loader_.reset(new CnfBulkLoader(cnf, threads_size_));
+        };
+        
+        virtual void append_clause(Cnf& cnf, const literalid_t* const literals, const clause_size_t literals_size) {
+            if (loader_) {
+                loader_->append_clause(literals, literals_size);
+            } else {
+                cnf.append_clause(literals, literals_size);
             };
+        };
+        
+        // the clause is normalized already, see Cnf::normalize_clause
+        virtual void append_normalized_clause(Cnf& cnf, const uint32_t* const p_clause) {
+            if (loader_) {
+                loader_->append_normalized_clause(p_clause);
+            } else {
+                cnf.append_normalized_clause(p_clause);
+            };
+        };
+        
+        // called once reading stops, whether at the end or on an error
+        virtual void finalize(Cnf&) {
+            if (loader_) {
+                loader_->execute();
+                loader_.reset();
+            };
+        };
+        
+    public:
+        // threads_size for parsing clauses, see parallel_threads_size
+        DimacsStreamReader(std::istream& stream, const unsigned threads_size = 1):
+            TextStreamReader<Cnf>(stream), threads_size_(parallel_threads_size(threads_size)) {};
+        DimacsStreamReader(std::istream& stream, const char* const buffer, const size_t buffer_size,
+                           const unsigned threads_size = 1):
+            TextStreamReader<Cnf>(stream, buffer, buffer_size), threads_size_(parallel_threads_size(threads_size)) {};
+        
+        virtual void read(Cnf& value) override {
+            bool is_header_read = false;
+            std::vector<literalid_t> literals;
             
-            read_eof();
+            try {
+                // the size of the input is known if it is buffered
+                TraceSpan span(stParse, "clauses");
+                const size_t bytes_total = is_buffered() ? get_buffer_size() : 0;
+                while (!is_eof()) {
+                    if (is_symbol('c')) {
+                        read_comment(value);
+                    } else if (is_symbol('p')) {
+                        assert(!is_header_read);
+                        read_header(value);
+                        is_header_read = true;
+                        if (threads_size_ > 1 && is_buffered() && !is_eof()) {
+                            read_clauses_parallel(value);
+                        };
+                    } else {
+                        assert(is_header_read);
+                        read_clause(literals);
+                        append_clause(value, literals.data(), literals.size());
+                        if ((++clauses_read_ & 0xFFFF) == 0) {
+                            span.progress(clauses_read_, bytes_total > 0 ? get_buffer_offset() : 0, bytes_total);
+                        };
+                    }
+                };
+                
+                read_eof();
+                span.set_items(clauses_read_);
+                span.set_bytes(bytes_total);
+            }
+            catch (...) {
+                // the clauses read before the error remain in the formula
+                finalize(value);
+                throw;
+            };
+            finalize(value);
         };
     };
     
@@ -157,12 +382,9 @@ namespace bal {
         };
         
         virtual void write_clauses(const Cnf& value) {
-            const uint32_t* data = value.data();
-            const uint32_t* data_end = data + value.data_size();
-            while (data < data_end) {
-                Cnf::print_clause(stream(), data, " 0\n");
-                data += (*data & 0xFFFF) + 1;
-            };
+            value.for_each_clause([&](const uint32_t* const p_clause) {
+                Cnf::print_clause(stream(), p_clause, " 0\n");
+            });
         };
         
     public:
@@ -8,9 +8,15 @@
 #ifndef graphml_h
 #define graphml_h
 
-#include <set>
+#include <algorithm>
 #include <map>
+#include <vector>
 #include "streamable.hpp"
+#include "textwriter.hpp"
+#include "hashset.hpp"
+#include "parallel.hpp"
+#include "radixsort.hpp"
+#include "trace.hpp"
 #include "cnf.hpp"
 
 namespace bal {
@@ -18,41 +24,61 @@ namespace bal {
     // outputs an undirected graph
     // nodes correspond to variables; node IDs match DIMACS variable numbers
     // there is an edge between two variables if those variables occur in the same clause
-    class GraphMLStreamWriter: public StreamWriter<Cnf> {
+    // with several threads, nodes and edges are formatted by chunks in parallel, see write_parallel
+    class GraphMLStreamWriter: public TextStreamWriter<Cnf> {
+    private:
+        const bool is_sorted_;
+        const unsigned tasks_size_;
+        // community of each variable written as a node attribute, if any
+        const std::vector<uint32_t>* const communities_;
+        // edge keys found but not written yet, only used with several threads
+        std::vector<uint64_t> new_edges_;
+        
     protected:
+        // DIMACS variable number
+        static inline uint32_t variable_number(const variableid_t variable_id) {
+            assert(variable_id <= VARIABLEID_MAX);
+            return variable_id + 1;
+        };
+        
         virtual void write_header(const Cnf& value) {
-            stream() << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << std::endl;
-            stream() << "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" xsi:schemaLocation=\"http://graphml.graphdrawing.org/xmlns http://graphml.graphdrawing.org/xmlns/1.0/graphml.xsd\">" << std::endl;
-            stream() << "<graph id=\"CNF\" edgedefault=\"undirected\">" << std::endl;
-            stream() << "<key id=\"n_variable_name\" for=\"node\" attr.name=\"variable_name\" attr.type=\"string\"/>" << std::endl;
-            stream() << "<key id=\"n_variable_index\" for=\"node\" attr.name=\"variable_index\" attr.type=\"int\"/>" << std::endl;
-            stream() << "<key id=\"n_variable_id\" for=\"node\" attr.name=\"variable_id\" attr.type=\"int\"/>" << std::endl;
-            stream() << "<key id=\"n_label\" for=\"node\" attr.name=\"label\" attr.type=\"string\"/>" << std::endl;
+            out() << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+            out() << "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" xsi:schemaLocation=\"http://graphml.graphdrawing.org/xmlns http://graphml.graphdrawing.org/xmlns/1.0/graphml.xsd\">\n";
+            out() << "<graph id=\"CNF\" edgedefault=\"undirected\">\n";
+            out() << "<key id=\"n_variable_name\" for=\"node\" attr.name=\"variable_name\" attr.type=\"string\"/>\n";
+            out() << "<key id=\"n_variable_index\" for=\"node\" attr.name=\"variable_index\" attr.type=\"int\"/>\n";
+            out() << "<key id=\"n_variable_id\" for=\"node\" attr.name=\"variable_id\" attr.type=\"int\"/>\n";
+            out() << "<key id=\"n_label\" for=\"node\" attr.name=\"label\" attr.type=\"string\"/>\n";
+            if (communities_ != nullptr) {
+                out() << "<key id=\"n_community\" for=\"node\" attr.name=\"community\" attr.type=\"int\"/>\n";
+            };
         };
         
         void write_footer(const Cnf& value) {
-            stream() << "</graph>" << std::endl;
-            stream() << "</graphml>" << std::endl;
+            out() << "</graph>\n";
+            out() << "</graphml>\n";
         };
         
-        void write_variable(const variableid_t variable_id, const char* const name = nullptr, const unsigned index = 0) {
-            stream() << std::dec;
-            stream() << "<node id=\"v"  << literal_t(variable_t(variable_id)) << "\">" << std::endl;
-            stream() << "<data key=\"n_variable_id\">" << literal_t(variable_t(variable_id)) << "</data>" << std::endl;
+        void write_variable(TextWriter& out, const variableid_t variable_id, const char* const name = nullptr, const unsigned index = 0) {
+            out << "<node id=\"v"  << variable_number(variable_id) << "\">\n";
+            out << "<data key=\"n_variable_id\">" << variable_number(variable_id) << "</data>\n";
             if (name != nullptr) {
-                stream() << "<data key=\"n_variable_name\">" << name << "</data>" << std::endl;
-                stream() << "<data key=\"n_variable_index\">" << index << "</data>" << std::endl;
+                out << "<data key=\"n_variable_name\">" << name << "</data>\n";
+                out << "<data key=\"n_variable_index\">" << index << "</data>\n";
             };
-            stream() << "<data key=\"n_label\">";
+            out << "<data key=\"n_label\">";
             if (name != nullptr) {
-                stream() << name << "[" << index << "](";
+                out << name << "[" << index << "](";
             };
-            stream() << literal_t(variable_t(variable_id));
+            out << variable_number(variable_id);
             if (name != nullptr) {
-                stream() << ")";
+                out << ")";
+            };
+            out << "</data>\n";
+            if (communities_ != nullptr) {
+                out << "<data key=\"n_community\">" << (*communities_)[variable_id] << "</data>\n";
             };
-            stream() << "</data>" << std::endl;
-            stream() << "</node>" << std::endl;
+            out << "</node>\n";
         };
         
         // first, write all variables that ar epart of named ones
@@ -60,8 +86,14 @@ namespace bal {
         // link binary variable to the first named variable it occurs in
         // and ignore other ones if any
         void write_variables(const Cnf& value) {
-            bool is_processed[value.variables_size()];
-            std::fill(is_processed, is_processed + value.variables_size(), false);
+            typedef struct {
+                variableid_t variable_id;
+                const char* name;
+                unsigned index;
+            } named_variable_t;
+            
+            std::vector<bool> is_processed(value.variables_size(), false);
+            std::vector<named_variable_t> named_variables;
             
             const formula_named_variables_t& nv = value.get_named_variables();
             for (formula_named_variables_t::const_iterator it = nv.begin(); it != nv.end(); ++it) {
@@ -70,127 +102,348 @@ namespace bal {
                 for (auto i = 0; i < nv_variables.size(); i++) {
                     if (literal_t__is_variable(nv_variables.data()[i])) {
                         const variableid_t variable_id = literal_t__variable_id(nv_variables.data()[i]);
-                        if (!is_processed[variable_id]) {
-                            write_variable(variable_id, nv_name.c_str(), i);
+                        // named variables may refer to variables beyond those of the header
+                        if (variable_id < is_processed.size() && !is_processed[variable_id]) {
+                            named_variables.push_back(named_variable_t{variable_id, nv_name.c_str(), (unsigned)i});
                             is_processed[variable_id] = true;
                         };
                     };
                 };
             };
             
-            for (auto i = 0; i < value.variables_size(); i++) {
-                if (!is_processed[i]) {
-                    write_variable(i);
-                    is_processed[i] = true;
+            write_parallel(tasks_size_, named_variables.size(), [&](TextWriter& out, const size_t begin, const size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    write_variable(out, named_variables[i].variable_id, named_variables[i].name, named_variables[i].index);
+                };
+            });
+            
+            write_parallel(tasks_size_, value.variables_size(), [&](TextWriter& out, const size_t begin, const size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    if (!is_processed[i]) {
+                        write_variable(out, (variableid_t)i);
+                    };
+                };
+            });
+        };
+        
+        // edges are keyed as (target << 32) | source where source < target, the key is never 0
+        typedef UInt64HashSet edges_set_t;
+        
+        static inline uint64_t edge_key(const variableid_t source, const variableid_t target) {
+            return ((uint64_t)target << 32) | source;
+        };
+        
+        static void write_edge(TextWriter& out, const variableid_t source, const variableid_t target) {
+            out << "<edge source=\"v" << variable_number(source) << "\" target=\"v" << variable_number(target) << "\"/>\n";
+        };
+        
+        void write_new_edges() {
+            write_parallel(tasks_size_, new_edges_.size(), [this](TextWriter& out, const size_t begin, const size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    write_edge(out, new_edges_[i] & 0xFFFFFFFF, new_edges_[i] >> 32);
+                };
+            });
+            new_edges_.clear();
+        };
+        
+        // the order of edges is kept, they are collected until there are enough for every thread
+        inline void write_new_edge(const variableid_t source, const variableid_t target) {
+            if (tasks_size_ <= 1) {
+                write_edge(out(), source, target);
+            } else {
+                new_edges_.push_back(edge_key(source, target));
+                if (new_edges_.size() >= CHUNK_ITEMS_SIZE * tasks_size_) {
+                    write_new_edges();
                 };
             };
         };
         
-        virtual void write_clauses(const Cnf& value) {
-            stream() << std::dec;
-            std::set<uint64_t> existing_edges;
-            
-            const uint32_t* data = value.data();
-            const uint32_t* data_end = data + value.data_size();
-            while (data < data_end) {
-                // iterate literal pairs
-                // it is guaranteed that the sequence is sorted and no duplicates exist
-                for (auto i = 0; i < _clause_size(data); i++) {
-                    for (auto j = i + 1; j < _clause_size(data); j++) {
-                        const variableid_t source = literal_t__variable_id(_clause_literal(data, i));
-                        const variableid_t target = literal_t__variable_id(_clause_literal(data, j));
-                        const uint64_t key = ((uint64_t)target << 32) | source;
-                        
-                        // check if the adge exists already; ignore if so, add otherwise
-                        auto it = existing_edges.find(key);
-                        if (it == existing_edges.end()) {
-                            existing_edges.insert(key);
-                            stream() << "<edge source=\"v" << literal_t(variable_t(source)) << "\" target=\"v" << literal_t(variable_t(target)) << "\"/>" << std::endl;
+        // SIZE is the clause size if known at compile time, 0 otherwise
+        template<clause_size_t SIZE>
+        size_t write_clause_edges_(const uint32_t* const p_clause, edges_set_t& existing_edges) {
+            const clause_size_t clause_size = SIZE > 0 ? SIZE : _clause_size(p_clause);
+            size_t edges_size = 0;
+            // iterate literal pairs
+            // it is guaranteed that the sequence is sorted and no duplicates exist
+            for (clause_size_t i = 0; i < clause_size; i++) {
+                const variableid_t source = literal_t__variable_id(_clause_literal(p_clause, i));
+                for (clause_size_t j = i + 1; j < clause_size; j++) {
+                    const variableid_t target = literal_t__variable_id(_clause_literal(p_clause, j));
+                    // ignore the edge if it exists already
+                    if (existing_edges.insert(edge_key(source, target))) {
+                        if (!is_sorted_) {
+                            write_new_edge(source, target);
                         };
+                        edges_size++;
                     };
                 };
-                
-                data += _clause_memory_size(data);
             };
+            return edges_size;
+        };
+        
+        // adds edges for all variable pairs of the clause unless added already
+        // new edges are written straight away unless the output is sorted
+        // returns number of edges added
+        size_t write_clause_edges(const uint32_t* const p_clause, edges_set_t& existing_edges) {
+            // aggregated clauses are the most common ones, the loops are unrolled for them
+            switch (_clause_size(p_clause)) {
+                case 1: return 0;
+                case 2: return write_clause_edges_<2>(p_clause, existing_edges);
+                case 3: return write_clause_edges_<3>(p_clause, existing_edges);
+                case 4: return write_clause_edges_<4>(p_clause, existing_edges);
+                default: return write_clause_edges_<0>(p_clause, existing_edges);
+            };
+        };
+        
+        // writes all edges ordered by target then source variable, same as the weighted output
+        void write_sorted_edges(const edges_set_t& existing_edges) {
+            std::vector<uint64_t> keys;
+            keys.reserve(existing_edges.size());
+            existing_edges.for_each([&keys](const uint64_t key) { keys.push_back(key); });
+            std::sort(keys.begin(), keys.end());
+            write_parallel(tasks_size_, keys.size(), [&keys](TextWriter& out, const size_t begin, const size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    write_edge(out, keys[i] & 0xFFFFFFFF, keys[i] >> 32);
+                };
+            });
+        };
+        
+        // returns the number of edges written
+        virtual size_t write_clauses(const Cnf& value) {
+            edges_set_t existing_edges;
+            // a clause of 3 literals produces as many edges; most of them are distinct for large formulas
+            existing_edges.reserve(value.literals_size(true));
+            
+            value.for_each_clause([&](const uint32_t* const p_clause) {
+                write_clause_edges(p_clause, existing_edges);
+            });
+            
+            if (is_sorted_) {
+                write_sorted_edges(existing_edges);
+            } else {
+                write_new_edges();
+            };
+            return existing_edges.size();
         };
         
     public:
-        GraphMLStreamWriter(std::ostream& stream): StreamWriter<Cnf>(stream) {};
+        // if is_sorted is set, edges are written in a deterministic order after all of them are known
+        // otherwise, each edge is written as soon as it is found
+        // threads_size, see parallel_threads_size
+        // communities, if given, assigns each variable a community, see Louvain
+        GraphMLStreamWriter(std::ostream& stream, const bool is_sorted = false, const unsigned threads_size = 1,
+                            const std::vector<uint32_t>* const communities = nullptr):
+            TextStreamWriter<Cnf>(stream), is_sorted_(is_sorted), tasks_size_(parallel_threads_size(threads_size)),
+            communities_(communities) {};
+        
+        // passes all edges found so far to the stream, e.g. if reading stopped on an error
+        void flush() {
+            write_new_edges();
+            TextStreamWriter<Cnf>::flush();
+        };
+        
+        bool is_sorted() const { return is_sorted_; };
         
         virtual void write(const Cnf& value) override {
             write_header(value);
-            write_variables(value);
-            write_clauses(value);
+            {
+                TraceSpan span(stVariables, "variables");
+                write_variables(value);
+                span.set_items(value.variables_size());
+            };
+            {
+                TraceSpan span(stEdges, "edges");
+                span.set_items(write_clauses(value));
+            };
             write_footer(value);
+            flush();
         };
     };
     
+    // writes the graph while the formula is being read, clauses are not retained
+    // the formula supplies variables size, named variables and parameters only
+    // nodes are written in front of the first edge, so they reflect named variables
+    // defined before the first clause, which is where "c var" lines normally are
+    // the output is the same as GraphMLStreamWriter produces for the complete formula then
+    class GraphMLStreamingWriter: public GraphMLStreamWriter {
+    private:
+        edges_set_t existing_edges_;
+        bool is_variables_written_ = false;
+        clauses_size_t clauses_size_ = 0;
+        size_t literals_size_ = 0;
+        size_t edges_size_ = 0;
+        
+    public:
+        GraphMLStreamingWriter(std::ostream& stream, const bool is_sorted = false, const unsigned threads_size = 1):
+            GraphMLStreamWriter(stream, is_sorted, threads_size) {};
+        
+        void begin(const Cnf& value) {
+            existing_edges_.clear();
+            is_variables_written_ = false;
+            clauses_size_ = 0;
+            literals_size_ = 0;
+            edges_size_ = 0;
+            write_header(value);
+        };
+        
+        // the clause must be normalized, see Cnf::normalize_clause
+        void append_clause(const Cnf& value, const uint32_t* const p_clause) {
+            if (!is_variables_written_) {
+                write_variables(value);
+                is_variables_written_ = true;
+            };
+            edges_size_ += write_clause_edges(p_clause, existing_edges_);
+            clauses_size_++;
+            literals_size_ += _clause_size(p_clause);
+        };
+        
+        void end(const Cnf& value) {
+            if (!is_variables_written_) {
+                write_variables(value);
+                is_variables_written_ = true;
+            };
+            if (is_sorted()) {
+                write_sorted_edges(existing_edges_);
+            } else {
+                write_new_edges();
+            };
+            write_footer(value);
+            flush();
+        };
+        
+        // clauses appended so far; duplicates are not detected unlike for Cnf
+        clauses_size_t clauses_size() const { return clauses_size_; };
+        size_t literals_size() const { return literals_size_; };
+        size_t edges_size() const { return edges_size_; };
+        
+        virtual void write(const Cnf& value) override {
+            begin(value);
+            value.for_each_clause([&](const uint32_t* const p_clause) {
+                append_clause(value, p_clause);
+            });
+            end(value);
+        };
+    };
+    
+    // edges are aggregated in parallel, each thread emitting entries for a range of clauses;
+    // entries are radix sorted by edge, the sort is stable so that entries of the same edge
+    // remain in clause order; then ranges of the sorted entries are reduced into edges in parallel
+    // weights of an edge are thus summed in the same order whatever the number of threads
     class GraphMLWeightedStreamWriter: public GraphMLStreamWriter {
+    private:
+        const unsigned threads_size_;
+        
+        // an edge of a clause, the cardinality and the weight follow from the clause header
+        typedef struct {
+            uint64_t key;
+            uint32_t clause_header;
+        } edge_entry_t;
+        
+        typedef struct {
+            variableid_t source;
+            variableid_t target;
+            uint32_t cardinality;
+            double weight;
+        } edge_t;
+        
     protected:
         virtual void write_header(const Cnf& value) override {
             GraphMLStreamWriter::write_header(value);
-            stream() << "<key id=\"e_cardinality\" for=\"edge\" attr.name=\"cardinality\" attr.type=\"int\"/>" << std::endl;
-            stream() << "<key id=\"e_weight\" for=\"edge\" attr.name=\"weight\" attr.type=\"double\"/>" << std::endl;
+            out() << "<key id=\"e_cardinality\" for=\"edge\" attr.name=\"cardinality\" attr.type=\"int\"/>\n";
+            out() << "<key id=\"e_weight\" for=\"edge\" attr.name=\"weight\" attr.type=\"double\"/>\n";
         };
         
-        virtual void write_clauses(const Cnf& value) override {
-            typedef struct {
-                unsigned cardinality;
-                double weight;
-            } edge_data_t;
+        virtual size_t write_clauses(const Cnf& value) override {
+            const unsigned tasks_size = parallel_threads_size(threads_size_);
             
-            stream() << std::dec;
-            std::map<uint64_t, edge_data_t> existing_edges;
+            std::vector<uint32_t> range_positions(tasks_size + 1);
+            std::vector<clauses_size_t> range_first_clauses(tasks_size + 1);
+            value.split_clauses(tasks_size, range_positions.data(), range_first_clauses.data());
             
-            const uint32_t* data = value.data();
-            const uint32_t* data_end = data + value.data_size();
-            while (data < data_end) {
-                // iterate literal pairs
-                // it is guaranteed that the sequence is sorted and no duplicates exist
-                // weight is calculated such that the sum of weights of edges generated from a clause is 1
-                for (auto i = 0; i < _clause_size(data); i++) {
-                    if (_clause_size(data) > 1) {
-                        uint16_t cardinality = 1;
-                        if (_clause_size(data) < 4) {
-                            cardinality = get_cardinality_uint16(_clause_flags(data));
-                        };
-                        
-                        const double weight = 2.0 * cardinality / _clause_size(data) / (_clause_size(data) - 1);
-                        
-                        for (auto j = i + 1; j < _clause_size(data); j++) {
-                            const variableid_t source = literal_t__variable_id(_clause_literal(data, i));
-                            const variableid_t target = literal_t__variable_id(_clause_literal(data, j));
-                            const uint64_t key = ((uint64_t)target << 32) | source;
-                            
-                            // check if the adge exists already; ignore if so, add otherwise
-                            auto it = existing_edges.find(key);
-                            if (it == existing_edges.end()) {
-                                const edge_data_t edge_data{cardinality, weight};
-                                existing_edges.insert({key, edge_data});
-                            } else {
-                                it->second.cardinality += cardinality;
-                                it->second.weight += weight;
-                            };
+            // the key orders edges by target then source, it takes as few bits as the variable IDs need
+            const unsigned variable_bits = radix_sort_bits(value.variables_size());
+            const uint64_t variable_mask = ((uint64_t)1 << variable_bits) - 1;
+            
+            // each clause of size k produces k * (k - 1) / 2 entries
+            std::vector<size_t> range_entries(tasks_size + 1, 0);
+            parallel_execute(tasks_size, [&](const unsigned index) {
+                size_t entries_size = 0;
+                value.for_each_clause(range_positions[index], range_positions[index + 1], [&](const uint32_t* const p_clause) {
+                    const size_t clause_size = _clause_size(p_clause);
+                    entries_size += clause_size * (clause_size - 1) / 2;
+                });
+                range_entries[index] = entries_size;
+            });
+            const size_t entries_size = parallel_exclusive_scan(tasks_size, range_entries.data(), tasks_size);
+            
+            // iterate literal pairs
+            // it is guaranteed that the sequence is sorted and no duplicates exist
+            std::vector<edge_entry_t> entries(entries_size);
+            parallel_execute(tasks_size, [&](const unsigned index) {
+                edge_entry_t* p_entry = entries.data() + range_entries[index];
+                value.for_each_clause(range_positions[index], range_positions[index + 1], [&](const uint32_t* const p_clause) {
+                    for (auto i = 0; i < _clause_size(p_clause); i++) {
+                        const variableid_t source = literal_t__variable_id(_clause_literal(p_clause, i));
+                        for (auto j = i + 1; j < _clause_size(p_clause); j++) {
+                            const variableid_t target = literal_t__variable_id(_clause_literal(p_clause, j));
+                            *p_entry++ = edge_entry_t{((uint64_t)target << variable_bits) | source, *p_clause};
                         };
                     };
+                });
+            });
+            
+            parallel_radix_sort(tasks_size, entries.data(), entries.size(), variable_bits * 2,
+                                [](const edge_entry_t& entry) { return entry.key; });
+            
+            // each task reduces the edges starting within its range of entries
+            // weight is calculated such that the sum of weights of edges generated from a clause is 1
+            std::vector<std::vector<edge_t>> range_edges(tasks_size);
+            parallel_for(tasks_size, entries.size(), [&](const unsigned index, size_t begin, size_t end) {
+                while (begin > 0 && begin < end && entries[begin].key == entries[begin - 1].key) {
+                    begin++;
                 };
-                
-                data += _clause_memory_size(data);
-            };
+                while (begin < end && end < entries.size() && entries[end].key == entries[end - 1].key) {
+                    end++;
+                };
+                std::vector<edge_t>& edges = range_edges[index];
+                for (size_t i = begin; i < end; i++) {
+                    const uint32_t header = entries[i].clause_header;
+                    const uint16_t cardinality = get_clause_header_cardinality(header);
+                    const double weight = 2.0 * cardinality / _clause_header_size(header) / (_clause_header_size(header) - 1);
+                    if (i == begin || entries[i].key != entries[i - 1].key) {
+                        const variableid_t source = (variableid_t)(entries[i].key & variable_mask);
+                        const variableid_t target = (variableid_t)(entries[i].key >> variable_bits);
+                        edges.push_back(edge_t{source, target, cardinality, weight});
+                    } else {
+                        edges.back().cardinality += cardinality;
+                        edges.back().weight += weight;
+                    };
+                };
+            });
+            entries.clear();
+            entries.shrink_to_fit();
             
-            for (auto edge: existing_edges) {
-                const variableid_t source = edge.first & 0xFFFFFFFF;
-                const variableid_t target = edge.first >> 32;
-                
-                stream() << "<edge source=\"v" << literal_t(variable_t(source)) << "\" target=\"v" << literal_t(variable_t(target)) << "\">" << std::endl;
-                stream() << "<data key=\"e_cardinality\">" << edge.second.cardinality << "</data>" << std::endl;
-                stream() << "<data key=\"e_weight\">" << edge.second.weight << "</data>" << std::endl;
-                stream() << "</edge>" << std::endl;
+            size_t edges_size = 0;
+            for (auto& edges: range_edges) {
+                edges_size += edges.size();
+                write_parallel(tasks_size, edges.size(), [&edges](TextWriter& out, const size_t begin, const size_t end) {
+                    for (size_t i = begin; i < end; i++) {
+                        const edge_t& edge = edges[i];
+                        out << "<edge source=\"v" << variable_number(edge.source) << "\" target=\"v" << variable_number(edge.target) << "\">\n";
+                        out << "<data key=\"e_cardinality\">" << edge.cardinality << "</data>\n";
+                        out << "<data key=\"e_weight\">" << edge.weight << "</data>\n";
+                        out << "</edge>\n";
+                    };
+                });
             };
+            return edges_size;
         };
         
     public:
-        GraphMLWeightedStreamWriter(std::ostream& stream): GraphMLStreamWriter(stream) {};
+        // threads_size, see parallel_threads_size
+        GraphMLWeightedStreamWriter(std::ostream& stream, const unsigned threads_size = 1,
+                                    const std::vector<uint32_t>* const communities = nullptr):
+            GraphMLStreamWriter(stream, true, threads_size, communities), threads_size_(threads_size) {};
     };
     
 };
@@ -0,0 +1,64 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef graphmlstream_hpp
+#define graphmlstream_hpp
+
+#include <vector>
+#include "dimacs.hpp"
+#include "graphml.hpp"
+
+namespace bal {
+    
+    // converts DIMACS CNF into GraphML in a single pass without storing the clauses
+    // the formula receives the header, named variables and parameters only
+    // each clause is normalized and passed to the writer as soon as it is read
+    // clauses are read on the calling thread so that no more than one is held in memory
+    // TextStreamReader is a virtual base, so it is initialized here rather than by DimacsStreamReader
+    class DimacsGraphMLStreamReader: public DimacsStreamReader {
+    private:
+        GraphMLStreamingWriter& writer_;
+        std::vector<uint32_t> clause_;
+        
+    protected:
+        virtual void initialize(Cnf& cnf, const variables_size_t variables_size, const clauses_size_t) override {
+            // neither the clauses buffer nor the bulk loader is needed, finalize has nothing to load then
+            cnf.initialize(variables_size, 0);
+            writer_.begin(cnf);
+        };
+        
+        virtual void append_clause(Cnf& cnf, const literalid_t* const literals, const clause_size_t literals_size) override {
+            assert(literals_size > 0);
+            clause_.resize(literals_size + 1);
+            std::copy(literals, literals + literals_size, _clause_literals(clause_.data()));
+            clause_[0] = Cnf::normalize_clause(_clause_literals(clause_.data()), literals_size);
+            // ignore the clause if it is always satisfied
+            if (clause_[0] != 0) {
+                writer_.append_clause(cnf, clause_.data());
+            };
+        };
+        
+        virtual void append_normalized_clause(Cnf& cnf, const uint32_t* const p_clause) override {
+            writer_.append_clause(cnf, p_clause);
+        };
+        
+    public:
+        DimacsGraphMLStreamReader(std::istream& stream, GraphMLStreamingWriter& writer):
+            TextStreamReader<Cnf>(stream), DimacsStreamReader(stream), writer_(writer) {};
+        DimacsGraphMLStreamReader(std::istream& stream, const char* const buffer, const size_t buffer_size,
+                                  GraphMLStreamingWriter& writer):
+            TextStreamReader<Cnf>(stream, buffer, buffer_size), DimacsStreamReader(stream, buffer, buffer_size),
+            writer_(writer) {};
+        
+        virtual void read(Cnf& value) override {
+            DimacsStreamReader::read(value);
+            writer_.end(value);
+        };
+    };
+};
+
+#endif /* graphmlstream_hpp */
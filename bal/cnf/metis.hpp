@@ -0,0 +1,124 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef metis_hpp
+#define metis_hpp
+
+#include <stdint.h>
+#include <vector>
+#include "streamable.hpp"
+#include "variableincidencegraph.hpp"
+#include "cnf.hpp"
+
+namespace bal {
+
+    // variable incidence graph in METIS .graph format
+    // vertex i is DIMACS variable i; each line lists the neighbours of a vertex
+    // METIS takes integer weights only, so the edge weight is its cardinality,
+    // i.e. the number of clauses the edge comes from
+    class MetisStreamWriter: public TextStreamWriter<Cnf> {
+    private:
+        const bool is_weighted_;
+        const unsigned tasks_size_;
+
+    public:
+        // threads_size, see parallel_threads_size
+        MetisStreamWriter(std::ostream& stream, const bool is_weighted = false, const unsigned threads_size = 1):
+            TextStreamWriter<Cnf>(stream), is_weighted_(is_weighted), tasks_size_(parallel_threads_size(threads_size)) {};
+
+        virtual void write(const Cnf& value) override {
+            const VariableIncidenceGraph graph(value, tasks_size_);
+            const auto& offsets = graph.offsets();
+            const auto& neighbours = graph.neighbours();
+            const auto& cardinalities = graph.cardinalities();
+
+            out() << graph.nodes_size() << " " << graph.edges_size();
+            if (is_weighted_) {
+                out() << " 001";
+            };
+            out() << "\n";
+
+            write_parallel(tasks_size_, graph.nodes_size(), [&](TextWriter& out, const size_t begin, const size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    for (auto offset = offsets[i]; offset < offsets[i + 1]; offset++) {
+                        if (offset > offsets[i]) {
+                            out << ' ';
+                        };
+                        out << neighbours[offset] + 1;
+                        if (is_weighted_) {
+                            out << ' ' << cardinalities[offset];
+                        };
+                    };
+                    out << '\n';
+                };
+            });
+            flush();
+        };
+    };
+
+    // clause hypergraph in hMETIS .hgr format
+    // vertex i is DIMACS variable i, each clause of two or more literals is a hyperedge;
+    // unit clauses connect nothing and are omitted
+    // clauses of up to 4 literals are aggregated by the formula, their hyperedge weight is
+    // the number of clauses aggregated, if weighted
+    class HMetisStreamWriter: public TextStreamWriter<Cnf> {
+    private:
+        // clauses are formatted in parallel in ranges of about this size
+        static const constexpr clauses_size_t RANGE_CLAUSES_SIZE = 1 << 14;
+
+        const bool is_weighted_;
+        const unsigned tasks_size_;
+
+    public:
+        // threads_size, see parallel_threads_size
+        HMetisStreamWriter(std::ostream& stream, const bool is_weighted = false, const unsigned threads_size = 1):
+            TextStreamWriter<Cnf>(stream), is_weighted_(is_weighted), tasks_size_(parallel_threads_size(threads_size)) {};
+
+        virtual void write(const Cnf& value) override {
+            clauses_size_t clauses_size = 0;
+            clauses_size_t hyperedges_size = 0;
+            value.for_each_clause([&](const uint32_t* const p_clause) {
+                clauses_size++;
+                hyperedges_size += _clause_size(p_clause) > 1 ? 1 : 0;
+            });
+
+            out() << hyperedges_size << " " << value.variables_size();
+            if (is_weighted_) {
+                out() << " 1";
+            };
+            out() << "\n";
+
+            // the ranges depend on the formula only, so does the output
+            const unsigned ranges_size = (unsigned)(clauses_size / RANGE_CLAUSES_SIZE + 1);
+            std::vector<uint32_t> range_positions(ranges_size + 1);
+            std::vector<clauses_size_t> range_first_clauses(ranges_size + 1);
+            value.split_clauses(ranges_size, range_positions.data(), range_first_clauses.data());
+
+            write_parallel(tasks_size_, ranges_size, [&](TextWriter& out, const size_t begin, const size_t end) {
+                value.for_each_clause(range_positions[begin], range_positions[end], [&](const uint32_t* const p_clause) {
+                    if (_clause_size(p_clause) < 2) {
+                        return;
+                    };
+                    if (is_weighted_) {
+                        out << get_clause_header_cardinality(*p_clause) << ' ';
+                    };
+                    for (clause_size_t j = 0; j < _clause_size(p_clause); j++) {
+                        if (j > 0) {
+                            out << ' ';
+                        };
+                        out << literal_t__variable_id(_clause_literal(p_clause, j)) + 1;
+                    };
+                    out << '\n';
+                });
+            }, 1);
+            flush();
+        };
+    };
+
+};
+
+#endif /* metis_hpp */
@@ -0,0 +1,242 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef graphstatistics_hpp
+#define graphstatistics_hpp
+
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include "intersection.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+#include "variableincidencegraph.hpp"
+
+namespace bal {
+
+    // the power law is fitted to the tails of at least this many nodes
+    static const constexpr uint32_t GRAPH_STATISTICS_TAIL_SIZE_MIN = 50;
+
+    // structural metrics of a variable incidence graph, computed in parallel
+    //   degrees - histogram, the number of nodes by degree
+    //   power law - exponent alpha of p(d) ~ d^-alpha for degrees from d_min, by the discrete maximum
+    //     likelihood approximation alpha = 1 + n / sum(ln(d / (d_min - 0.5))); d_min minimizes the
+    //     Kolmogorov-Smirnov distance between the degrees and the fit, see A. Clauset, C. R. Shalizi,
+    //     M. E. J. Newman. Power-law distributions in empirical data, 2009
+    //   components - connected components by a lock free union find, isolated nodes included
+    //   triangles - for each edge, the size of the intersection of the rows of its nodes, which
+    //     counts the triangles it is part of; each triangle is counted by its 3 edges
+    //   global clustering - 3 * triangles / connected triples
+    //   average local clustering - average over all nodes of the triangles of the node divided by
+    //     the pairs of its neighbours, 0 for nodes of degree below 2
+    // sums are taken in the order of nodes, so the figures do not depend on the number of threads
+    class GraphStatistics {
+    public:
+        typedef VariableIncidenceGraph::edge_offset_t edge_offset_t;
+
+    private:
+        const unsigned tasks_size_;
+        variables_size_t nodes_size_ = 0;
+        edge_offset_t edges_size_ = 0;
+        std::vector<uint64_t> degrees_histogram_;
+        double power_law_alpha_ = 0;
+        uint32_t power_law_degree_min_ = 0;
+        double power_law_distance_ = 0;
+        uint32_t components_size_ = 0;
+        uint32_t largest_component_size_ = 0;
+        uint64_t triangles_size_ = 0;
+        double global_clustering_ = 0;
+        double average_clustering_ = 0;
+
+        void get_degrees(const VariableIncidenceGraph& graph) {
+            degrees_histogram_.clear();
+            for (variableid_t i = 0; i < nodes_size_; i++) {
+                const edge_offset_t degree = graph.degree(i);
+                if (degree >= degrees_histogram_.size()) {
+                    degrees_histogram_.resize(degree + 1, 0);
+                };
+                degrees_histogram_[degree]++;
+            };
+        };
+
+        void fit_power_law() {
+            power_law_alpha_ = 0;
+            power_law_degree_min_ = 0;
+            power_law_distance_ = 0;
+            // tail_sizes[d] is the number of nodes of degree d or more
+            std::vector<uint64_t> tail_sizes(degrees_histogram_.size() + 1, 0);
+            for (size_t d = degrees_histogram_.size(); d > 0; d--) {
+                tail_sizes[d - 1] = tail_sizes[d] + degrees_histogram_[d - 1];
+            };
+            bool is_fitted = false;
+            // the tail spans two degrees at least
+            for (size_t degree_min = 1; degree_min + 1 < degrees_histogram_.size(); degree_min++) {
+                if (degrees_histogram_[degree_min] == 0) {
+                    continue;
+                };
+                if (tail_sizes[degree_min] < GRAPH_STATISTICS_TAIL_SIZE_MIN) {
+                    break;
+                };
+                const double tail_size = (double)tail_sizes[degree_min];
+                double log_sum = 0;
+                for (size_t d = degree_min; d < degrees_histogram_.size(); d++) {
+                    log_sum += degrees_histogram_[d] * log(d / (degree_min - 0.5));
+                };
+                if (log_sum <= 0) {
+                    continue;
+                };
+                const double alpha = 1 + tail_size / log_sum;
+                // the complementary CDFs, of the degrees and of the continuous approximation of the fit
+                double distance = 0;
+                for (size_t d = degree_min; d < degrees_histogram_.size(); d++) {
+                    if (degrees_histogram_[d] > 0) {
+                        const double fitted = pow((d - 0.5) / (degree_min - 0.5), 1 - alpha);
+                        distance = std::max(distance, fabs(tail_sizes[d] / tail_size - fitted));
+                    };
+                };
+                if (!is_fitted || distance < power_law_distance_) {
+                    power_law_alpha_ = alpha;
+                    power_law_degree_min_ = (uint32_t)degree_min;
+                    power_law_distance_ = distance;
+                    is_fitted = true;
+                };
+            };
+        };
+
+        // the root of the tree of the node, halving the path on the way
+        static uint32_t find(std::vector<std::atomic<uint32_t>>& parents, uint32_t node) {
+            uint32_t parent = parents[node].load(std::memory_order_relaxed);
+            while (parent != node) {
+                const uint32_t grandparent = parents[parent].load(std::memory_order_relaxed);
+                parents[node].compare_exchange_weak(parent, grandparent, std::memory_order_relaxed);
+                node = grandparent;
+                parent = parents[node].load(std::memory_order_relaxed);
+            };
+            return node;
+        };
+
+        // the root with the greater number is linked to the other one, so the trees stay acyclic
+        void get_components(const VariableIncidenceGraph& graph) {
+            std::vector<std::atomic<uint32_t>> parents(nodes_size_);
+            for (variableid_t i = 0; i < nodes_size_; i++) {
+                parents[i].store(i, std::memory_order_relaxed);
+            };
+            parallel_for(tasks_size_, nodes_size_, [&](const unsigned, const variableid_t begin, const variableid_t end) {
+                for (variableid_t source = begin; source < end; source++) {
+                    for (edge_offset_t offset = graph.offsets()[source]; offset < graph.offsets()[source + 1]; offset++) {
+                        const variableid_t target = graph.neighbours()[offset];
+                        if (target < source) {
+                            continue;
+                        };
+                        while (true) {
+                            uint32_t lhs = find(parents, source);
+                            uint32_t rhs = find(parents, target);
+                            if (lhs == rhs) {
+                                break;
+                            };
+                            if (lhs < rhs) {
+                                std::swap(lhs, rhs);
+                            };
+                            uint32_t expected = lhs;
+                            if (parents[lhs].compare_exchange_strong(expected, rhs, std::memory_order_relaxed)) {
+                                break;
+                            };
+                        };
+                    };
+                };
+            });
+            std::vector<uint32_t> sizes(nodes_size_, 0);
+            for (variableid_t i = 0; i < nodes_size_; i++) {
+                sizes[find(parents, i)]++;
+            };
+            components_size_ = 0;
+            largest_component_size_ = 0;
+            for (const uint32_t size: sizes) {
+                components_size_ += size > 0 ? 1 : 0;
+                largest_component_size_ = std::max(largest_component_size_, size);
+            };
+        };
+
+        // triangles of each node, doubled, as each one is found through both edges of the node
+        void get_triangles(const VariableIncidenceGraph& graph) {
+            std::vector<std::atomic<uint64_t>> node_triangles(nodes_size_);
+            for (variableid_t i = 0; i < nodes_size_; i++) {
+                node_triangles[i].store(0, std::memory_order_relaxed);
+            };
+            const variableid_t* const neighbours = graph.neighbours().data();
+            const edge_offset_t* const offsets = graph.offsets().data();
+            parallel_for(tasks_size_, nodes_size_, [&](const unsigned, const variableid_t begin, const variableid_t end) {
+                for (variableid_t source = begin; source < end; source++) {
+                    const variableid_t* const source_row = neighbours + offsets[source];
+                    const size_t source_degree = offsets[source + 1] - offsets[source];
+                    uint64_t source_triangles = 0;
+                    // neighbours greater than the source, the row is sorted
+                    for (size_t k = std::upper_bound(source_row, source_row + source_degree, source) - source_row; k < source_degree; k++) {
+                        const variableid_t target = source_row[k];
+                        const size_t triangles = intersection_size(source_row, source_degree, neighbours + offsets[target],
+                                                                   offsets[target + 1] - offsets[target]);
+                        source_triangles += triangles;
+                        node_triangles[target].fetch_add(triangles, std::memory_order_relaxed);
+                    };
+                    node_triangles[source].fetch_add(source_triangles, std::memory_order_relaxed);
+                };
+            });
+
+            uint64_t triangles_size = 0;
+            double triples_size = 0;
+            double local_clustering_sum = 0;
+            for (variableid_t i = 0; i < nodes_size_; i++) {
+                const uint64_t triangles = node_triangles[i].load(std::memory_order_relaxed) / 2;
+                const double degree = (double)graph.degree(i);
+                triangles_size += triangles;
+                if (degree >= 2) {
+                    const double pairs = degree * (degree - 1) / 2;
+                    triples_size += pairs;
+                    local_clustering_sum += triangles / pairs;
+                };
+            };
+            // each triangle is counted at its 3 nodes
+            triangles_size_ = triangles_size / 3;
+            global_clustering_ = triples_size > 0 ? 3.0 * triangles_size_ / triples_size : 0;
+            average_clustering_ = nodes_size_ > 0 ? local_clustering_sum / nodes_size_ : 0;
+        };
+
+    public:
+        // threads_size, see parallel_threads_size
+        GraphStatistics(const unsigned threads_size = 1): tasks_size_(parallel_threads_size(threads_size)) {};
+
+        void run(const VariableIncidenceGraph& graph) {
+            TraceSpan span(stGraphStatistics, "edges");
+            nodes_size_ = graph.nodes_size();
+            edges_size_ = graph.edges_size();
+            get_degrees(graph);
+            fit_power_law();
+            get_components(graph);
+            get_triangles(graph);
+            span.set_items(edges_size_);
+        };
+
+        variables_size_t nodes_size() const { return nodes_size_; };
+        edge_offset_t edges_size() const { return edges_size_; };
+        // the number of nodes by degree, up to the maximal degree
+        const std::vector<uint64_t>& degrees_histogram() const { return degrees_histogram_; };
+        // 0 if there are too few nodes of degree 1 or more to fit
+        double power_law_alpha() const { return power_law_alpha_; };
+        uint32_t power_law_degree_min() const { return power_law_degree_min_; };
+        // Kolmogorov-Smirnov distance of the fit
+        double power_law_distance() const { return power_law_distance_; };
+        uint32_t components_size() const { return components_size_; };
+        uint32_t largest_component_size() const { return largest_component_size_; };
+        uint64_t triangles_size() const { return triangles_size_; };
+        double global_clustering() const { return global_clustering_; };
+        double average_clustering() const { return average_clustering_; };
+    };
+};
+
+#endif /* graphstatistics_hpp */
@@ -0,0 +1,384 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef louvain_hpp
+#define louvain_hpp
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include "parallel.hpp"
+#include "trace.hpp"
+#include "variableincidencegraph.hpp"
+
+namespace bal {
+
+    // nodes of a batch, at least; a level has at most LOUVAIN_BATCHES_SIZE batches per sweep
+    static const constexpr uint32_t LOUVAIN_BATCH_SIZE_MIN = 64;
+    static const constexpr uint32_t LOUVAIN_BATCHES_SIZE = 256;
+    // sweeps over the nodes of a level stop when modularity grows less than this
+    static const constexpr double LOUVAIN_SWEEP_GAIN_MIN = 1e-6;
+    static const constexpr unsigned LOUVAIN_SWEEPS_SIZE_MAX = 100;
+
+    // communities of a variable incidence graph by the Louvain method, see
+    // V. D. Blondel et al. Fast unfolding of communities in large networks, 2008
+    // a level moves nodes between communities while modularity grows, then the communities
+    // become the nodes of the next level, until nodes stop moving or the levels are exhausted
+    // edges are weighted as in VariableIncidenceGraph
+    // nodes are moved in batches: the best community for each node of a batch is found in parallel
+    // against the communities before the batch, then the moves are applied in order;
+    // a node alone in its community joins another single node community only if its number is
+    // lower, so that such pairs do not swap endlessly
+    // batches do not depend on the number of threads, and neither do the communities found
+    class Louvain {
+    public:
+        typedef VariableIncidenceGraph::edge_offset_t edge_offset_t;
+        typedef uint32_t community_t;
+
+        static const constexpr unsigned LEVELS_UNLIMITED = 0;
+
+    private:
+        // a level; rows do not include the node itself, loops is the weight within the node
+        // with each edge counted in both directions, nullptr for the variable incidence graph
+        typedef struct {
+            uint32_t nodes_size;
+            const edge_offset_t* offsets;
+            const variableid_t* neighbours;
+            const double* weights;
+            const double* loops;
+        } graph_t;
+
+        typedef struct {
+            std::vector<edge_offset_t> offsets;
+            std::vector<variableid_t> neighbours;
+            std::vector<double> weights;
+            std::vector<double> loops;
+        } graph_storage_t;
+
+        // weights of the edges of a node by community, for a task; weights is 0 for communities
+        // not touched, as edge weights are positive
+        typedef struct {
+            std::vector<double> weights;
+            std::vector<community_t> touched;
+        } scratch_t;
+
+        const unsigned tasks_size_;
+        std::vector<community_t> communities_;
+        community_t communities_size_ = 0;
+        double modularity_ = 0;
+        unsigned levels_ = 0;
+
+        static graph_t graph_view(const VariableIncidenceGraph& graph) {
+            return graph_t{graph.nodes_size(), graph.offsets().data(), graph.neighbours().data(), graph.weights().data(), nullptr};
+        };
+
+        static graph_t graph_view(const graph_storage_t& storage) {
+            return graph_t{(uint32_t)storage.loops.size(), storage.offsets.data(), storage.neighbours.data(),
+                storage.weights.data(), storage.loops.data()};
+        };
+
+        // sums up the weights of the edges of the node by the community of the neighbour;
+        // communities are listed in the order they are first met
+        static void collect(const graph_t& graph, const uint32_t node, const community_t* const communities, scratch_t& scratch) {
+            for (edge_offset_t offset = graph.offsets[node]; offset < graph.offsets[node + 1]; offset++) {
+                const community_t community = communities[graph.neighbours[offset]];
+                if (scratch.weights[community] == 0) {
+                    scratch.touched.push_back(community);
+                };
+                scratch.weights[community] += graph.weights[offset];
+            };
+        };
+
+        static void clear(scratch_t& scratch) {
+            for (const community_t community: scratch.touched) {
+                scratch.weights[community] = 0;
+            };
+            scratch.touched.clear();
+        };
+
+        // weighted degree of each node, loops included
+        void get_degrees(const graph_t& graph, std::vector<double>& degrees) const {
+            degrees.resize(graph.nodes_size);
+            parallel_for(tasks_size_, graph.nodes_size, [&](const unsigned, const uint32_t begin, const uint32_t end) {
+                for (uint32_t i = begin; i < end; i++) {
+                    double degree = graph.loops != nullptr ? graph.loops[i] : 0;
+                    for (edge_offset_t offset = graph.offsets[i]; offset < graph.offsets[i + 1]; offset++) {
+                        degree += graph.weights[offset];
+                    };
+                    degrees[i] = degree;
+                };
+            });
+        };
+
+        // sums are taken in the order of nodes for the result to be the same with any number of threads
+        static double sum(const std::vector<double>& values) {
+            double result = 0;
+            for (const double value: values) {
+                result += value;
+            };
+            return result;
+        };
+
+        // Q = sum over communities of in / 2m - (tot / 2m)^2, where in is the weight of the edges
+        // within the community and tot is the sum of the degrees of its nodes, both counting
+        // each edge in both directions; total_weight is 2m
+        double get_modularity(const graph_t& graph, const std::vector<double>& degrees, const double total_weight,
+                              const community_t* const communities, const community_t communities_size) const {
+            if (total_weight <= 0) {
+                return 0;
+            };
+            std::vector<double> inner_weights(graph.nodes_size);
+            parallel_for(tasks_size_, graph.nodes_size, [&](const unsigned, const uint32_t begin, const uint32_t end) {
+                for (uint32_t i = begin; i < end; i++) {
+                    double weight = graph.loops != nullptr ? graph.loops[i] : 0;
+                    for (edge_offset_t offset = graph.offsets[i]; offset < graph.offsets[i + 1]; offset++) {
+                        if (communities[graph.neighbours[offset]] == communities[i]) {
+                            weight += graph.weights[offset];
+                        };
+                    };
+                    inner_weights[i] = weight;
+                };
+            });
+            std::vector<double> totals(communities_size, 0);
+            for (uint32_t i = 0; i < graph.nodes_size; i++) {
+                totals[communities[i]] += degrees[i];
+            };
+            double expected = 0;
+            for (const double total: totals) {
+                expected += (total / total_weight) * (total / total_weight);
+            };
+            return sum(inner_weights) / total_weight - expected;
+        };
+
+        // the community that the node gains the most modularity in, its own one if none is better
+        // the gain of joining community c is proportional to the weight of the edges to c
+        // less tot(c) * degree / 2m, tot(c) without the node itself
+        static community_t find_best_community(const graph_t& graph, const uint32_t node, const std::vector<double>& degrees,
+                                               const double total_weight, const std::vector<community_t>& communities,
+                                               const std::vector<double>& totals, const std::vector<uint32_t>& sizes, scratch_t& scratch) {
+            collect(graph, node, communities.data(), scratch);
+            const double degree = degrees[node];
+            const community_t own = communities[node];
+            community_t best = own;
+            double best_gain = scratch.weights[own] - (totals[own] - degree) * degree / total_weight;
+            for (const community_t community: scratch.touched) {
+                if (community != own && !(sizes[own] == 1 && sizes[community] == 1 && community > own)) {
+                    const double gain = scratch.weights[community] - totals[community] * degree / total_weight;
+                    if (gain > best_gain) {
+                        best = community;
+                        best_gain = gain;
+                    };
+                };
+            };
+            clear(scratch);
+            return best;
+        };
+
+        // moves the nodes of the level, communities are numbered as the nodes initially
+        // nodes of a batch move at once, so a sweep may lower modularity; it is undone then
+        // returns the number of moves kept
+        size_t move_nodes(const graph_t& graph, const std::vector<double>& degrees, const double total_weight,
+                          std::vector<community_t>& communities) const {
+            const uint32_t nodes_size = graph.nodes_size;
+            std::vector<double> totals(degrees);
+            std::vector<uint32_t> sizes(nodes_size, 1);
+            std::vector<community_t> targets(nodes_size);
+            std::vector<community_t> previous_communities;
+            std::vector<scratch_t> scratches(tasks_size_);
+            for (scratch_t& scratch: scratches) {
+                scratch.weights.assign(nodes_size, 0);
+            };
+
+            const uint32_t batch_size = std::max(LOUVAIN_BATCH_SIZE_MIN, nodes_size / LOUVAIN_BATCHES_SIZE);
+            size_t moves_size = 0;
+            double modularity = get_modularity(graph, degrees, total_weight, communities.data(), nodes_size);
+            for (unsigned sweep = 0; sweep < LOUVAIN_SWEEPS_SIZE_MAX; sweep++) {
+                size_t sweep_moves_size = 0;
+                previous_communities = communities;
+                for (uint32_t batch_begin = 0; batch_begin < nodes_size; batch_begin += std::min(batch_size, nodes_size - batch_begin)) {
+                    const uint32_t batch_end = batch_begin + std::min(batch_size, nodes_size - batch_begin);
+                    parallel_for(tasks_size_, batch_end - batch_begin, [&](const unsigned index, const uint32_t begin, const uint32_t end) {
+                        for (uint32_t i = batch_begin + begin; i < batch_begin + end; i++) {
+                            targets[i] = find_best_community(graph, i, degrees, total_weight, communities, totals, sizes, scratches[index]);
+                        };
+                    });
+                    for (uint32_t i = batch_begin; i < batch_end; i++) {
+                        const community_t source = communities[i];
+                        const community_t target = targets[i];
+                        if (target != source) {
+                            totals[source] -= degrees[i];
+                            totals[target] += degrees[i];
+                            sizes[source]--;
+                            sizes[target]++;
+                            communities[i] = target;
+                            sweep_moves_size++;
+                        };
+                    };
+                };
+                const double sweep_modularity = get_modularity(graph, degrees, total_weight, communities.data(), nodes_size);
+                if (sweep_modularity < modularity) {
+                    communities.swap(previous_communities);
+                    break;
+                };
+                moves_size += sweep_moves_size;
+                if (sweep_moves_size == 0 || sweep_modularity - modularity < LOUVAIN_SWEEP_GAIN_MIN) {
+                    break;
+                };
+                modularity = sweep_modularity;
+            };
+            return moves_size;
+        };
+
+        // numbers the communities from 0 in the order of their first nodes, returns their number
+        static community_t renumber(std::vector<community_t>& communities) {
+            std::vector<community_t> numbers(communities.size(), UINT32_MAX);
+            community_t communities_size = 0;
+            for (community_t& community: communities) {
+                if (numbers[community] == UINT32_MAX) {
+                    numbers[community] = communities_size++;
+                };
+                community = numbers[community];
+            };
+            return communities_size;
+        };
+
+        // the graph of the communities; the edges between two communities are merged into one,
+        // the edges within a community become its loop
+        // weights are summed in the order of nodes then edges whatever the number of threads
+        graph_storage_t aggregate(const graph_t& graph, const std::vector<community_t>& communities,
+                                  const community_t communities_size) const {
+            // nodes of each community in their order
+            std::vector<uint32_t> members_offsets(communities_size + 1, 0);
+            for (uint32_t i = 0; i < graph.nodes_size; i++) {
+                members_offsets[communities[i] + 1]++;
+            };
+            for (community_t c = 0; c < communities_size; c++) {
+                members_offsets[c + 1] += members_offsets[c];
+            };
+            std::vector<uint32_t> members(graph.nodes_size);
+            {
+                std::vector<uint32_t> positions(members_offsets.begin(), members_offsets.end() - 1);
+                for (uint32_t i = 0; i < graph.nodes_size; i++) {
+                    members[positions[communities[i]]++] = i;
+                };
+            };
+
+            std::vector<scratch_t> scratches(tasks_size_);
+            for (scratch_t& scratch: scratches) {
+                scratch.weights.assign(communities_size, 0);
+            };
+            graph_storage_t result;
+            result.offsets.assign(communities_size + 1, 0);
+            result.loops.assign(communities_size, 0);
+
+            // pass 1: the number of neighbour communities of each community
+            // pass 2: the rows and the loops
+            for (const bool is_fill: {false, true}) {
+                if (is_fill) {
+                    const edge_offset_t edges_size = parallel_exclusive_scan(tasks_size_, result.offsets.data(), communities_size);
+                    result.offsets[communities_size] = edges_size;
+                    result.neighbours.resize(edges_size);
+                    result.weights.resize(edges_size);
+                };
+                parallel_for(tasks_size_, communities_size, [&](const unsigned index, const community_t begin, const community_t end) {
+                    scratch_t& scratch = scratches[index];
+                    for (community_t c = begin; c < end; c++) {
+                        double loop = 0;
+                        for (uint32_t m = members_offsets[c]; m < members_offsets[c + 1]; m++) {
+                            loop += graph.loops != nullptr ? graph.loops[members[m]] : 0;
+                            collect(graph, members[m], communities.data(), scratch);
+                        };
+                        edge_offset_t offset = is_fill ? result.offsets[c] : 0;
+                        for (const community_t community: scratch.touched) {
+                            if (community == c) {
+                                loop += scratch.weights[community];
+                            } else if (is_fill) {
+                                result.neighbours[offset] = community;
+                                result.weights[offset] = scratch.weights[community];
+                                offset++;
+                            } else {
+                                offset++;
+                            };
+                        };
+                        if (is_fill) {
+                            result.loops[c] = loop;
+                        } else {
+                            result.offsets[c] = offset;
+                        };
+                        clear(scratch);
+                    };
+                });
+            };
+            return result;
+        };
+
+    public:
+        // threads_size, see parallel_threads_size
+        Louvain(const unsigned threads_size = 1): tasks_size_(parallel_threads_size(threads_size)) {};
+
+        // finds the communities of the graph in up to levels_max levels, all of them if LEVELS_UNLIMITED
+        void run(const VariableIncidenceGraph& graph, const unsigned levels_max = LEVELS_UNLIMITED) {
+            TraceSpan span(stCommunities, "nodes");
+            const uint32_t nodes_size = graph.nodes_size();
+            communities_.resize(nodes_size);
+            for (uint32_t i = 0; i < nodes_size; i++) {
+                communities_[i] = i;
+            };
+            communities_size_ = nodes_size;
+            levels_ = 0;
+
+            graph_t level = graph_view(graph);
+            graph_storage_t storage;
+            std::vector<double> degrees;
+            get_degrees(level, degrees);
+            const double total_weight = sum(degrees);
+            while (total_weight > 0 && (levels_max == LEVELS_UNLIMITED || levels_ < levels_max)) {
+                std::vector<community_t> level_communities(level.nodes_size);
+                for (uint32_t i = 0; i < level.nodes_size; i++) {
+                    level_communities[i] = i;
+                };
+                if (move_nodes(level, degrees, total_weight, level_communities) == 0) {
+                    break;
+                };
+                const community_t level_communities_size = renumber(level_communities);
+                parallel_for(tasks_size_, nodes_size, [&](const unsigned, const uint32_t begin, const uint32_t end) {
+                    for (uint32_t i = begin; i < end; i++) {
+                        communities_[i] = level_communities[communities_[i]];
+                    };
+                });
+                communities_size_ = level_communities_size;
+                levels_++;
+                if (level_communities_size == level.nodes_size) {
+                    break;
+                };
+                storage = aggregate(level, level_communities, level_communities_size);
+                level = graph_view(storage);
+                get_degrees(level, degrees);
+            };
+
+            modularity_ = modularity(graph, communities_);
+            span.set_items(nodes_size);
+        };
+
+        // modularity of the partition of the graph, communities[node] < number of nodes
+        double modularity(const VariableIncidenceGraph& graph, const std::vector<community_t>& communities) const {
+            const graph_t level = graph_view(graph);
+            std::vector<double> degrees;
+            get_degrees(level, degrees);
+            return get_modularity(level, degrees, sum(degrees), communities.data(), graph.nodes_size());
+        };
+
+        // community of each node, numbered from 0 in the order of their first nodes
+        const std::vector<community_t>& communities() const { return communities_; };
+        community_t communities_size() const { return communities_size_; };
+        double modularity() const { return modularity_; };
+        // levels that moved nodes
+        unsigned levels() const { return levels_; };
+    };
+};
+
+#endif /* louvain_hpp */
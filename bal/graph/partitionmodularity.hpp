@@ -0,0 +1,270 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef partitionmodularity_hpp
+#define partitionmodularity_hpp
+
+#include <stdint.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "cnf.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+
+namespace bal {
+
+    // clauses are processed in this many ranges whatever the number of threads, the sums of
+    // the ranges are added up in order so that the result does not depend on the threads
+    static const constexpr unsigned PARTITION_RANGES_SIZE = 16;
+    // rounds of attaching unnamed variables to named neighbours, see pmNearest
+    static const constexpr unsigned PARTITION_NEAREST_ROUNDS_MAX = 16;
+    static const constexpr uint32_t PARTITION_NO_COMMUNITY = UINT32_MAX;
+
+    // how variables that are not part of any named variable are partitioned
+    //   pmResidual - all of them make one community
+    //   pmNearest - each joins the community of its named neighbours it shares the most weight with;
+    //     a round per hop, those not reached in PARTITION_NEAREST_ROUNDS_MAX rounds are residual
+    enum PartitionMode {pmResidual, pmNearest};
+
+    // partition of the variables into the named variables of the formula, the "c var" lines
+    // a community per named variable in the order of names; a variable belongs to the first
+    // named variable it occurs in, as for the node labels of the graph
+    // the residual community, if any, follows the named ones
+    class NamedPartition {
+    private:
+        std::vector<uint32_t> communities_;
+        std::vector<std::string> names_;
+
+        // the clauses of each range in parallel, f(range, p_clause)
+        template<typename F>
+        static void for_each_range(const Cnf& cnf, const unsigned tasks_size, F f) {
+            std::vector<uint32_t> range_positions(PARTITION_RANGES_SIZE + 1);
+            std::vector<clauses_size_t> range_first_clauses(PARTITION_RANGES_SIZE + 1);
+            cnf.split_clauses(PARTITION_RANGES_SIZE, range_positions.data(), range_first_clauses.data());
+            parallel_for(tasks_size, PARTITION_RANGES_SIZE, [&](const unsigned, const unsigned begin, const unsigned end) {
+                for (unsigned range = begin; range < end; range++) {
+                    cnf.for_each_clause(range_positions[range], range_positions[range + 1], [&](const uint32_t* const p_clause) {
+                        f(range, p_clause);
+                    });
+                };
+            });
+        };
+
+        // assigns unnamed variables adjacent to the assigned ones, returns the number assigned
+        // weights to each community are summed in the order of clauses
+        size_t attach_nearest(const Cnf& cnf, const unsigned tasks_size) {
+            typedef struct {
+                uint64_t key;
+                double weight;
+            } entry_t;
+
+            // (variable << 32) | community of a neighbour, and the weight of the edge
+            std::vector<std::vector<entry_t>> range_entries(PARTITION_RANGES_SIZE);
+            for_each_range(cnf, tasks_size, [&](const unsigned range, const uint32_t* const p_clause) {
+                const clause_size_t clause_size = _clause_size(p_clause);
+                if (clause_size > 1) {
+                    const double weight = 2.0 * get_clause_header_cardinality(*p_clause) / clause_size / (clause_size - 1);
+                    for (clause_size_t i = 0; i < clause_size; i++) {
+                        const variableid_t variable_id = literal_t__variable_id(_clause_literal(p_clause, i));
+                        if (communities_[variable_id] == PARTITION_NO_COMMUNITY) {
+                            for (clause_size_t j = 0; j < clause_size; j++) {
+                                const uint32_t community = communities_[literal_t__variable_id(_clause_literal(p_clause, j))];
+                                if (community != PARTITION_NO_COMMUNITY) {
+                                    range_entries[range].push_back(entry_t{((uint64_t)variable_id << 32) | community, weight});
+                                };
+                            };
+                        };
+                    };
+                };
+            });
+
+            std::vector<entry_t> entries;
+            for (std::vector<entry_t>& range: range_entries) {
+                entries.insert(entries.end(), range.begin(), range.end());
+                range.clear();
+                range.shrink_to_fit();
+            };
+            std::stable_sort(entries.begin(), entries.end(), [](const entry_t& lhs, const entry_t& rhs) { return lhs.key < rhs.key; });
+
+            // the heaviest community of each variable, the lowest one on a tie
+            size_t assigned_size = 0;
+            for (size_t i = 0; i < entries.size(); ) {
+                const variableid_t variable_id = (variableid_t)(entries[i].key >> 32);
+                uint32_t best = PARTITION_NO_COMMUNITY;
+                double best_weight = 0;
+                while (i < entries.size() && (variableid_t)(entries[i].key >> 32) == variable_id) {
+                    const uint64_t key = entries[i].key;
+                    double weight = 0;
+                    for (; i < entries.size() && entries[i].key == key; i++) {
+                        weight += entries[i].weight;
+                    };
+                    if (weight > best_weight) {
+                        best = (uint32_t)key;
+                        best_weight = weight;
+                    };
+                };
+                communities_[variable_id] = best;
+                assigned_size++;
+            };
+            return assigned_size;
+        };
+
+    public:
+        NamedPartition(const Cnf& cnf, const PartitionMode mode = pmResidual, const unsigned threads_size = 1) {
+            build(cnf, mode, threads_size);
+        };
+
+        // threads_size, see parallel_threads_size
+        void build(const Cnf& cnf, const PartitionMode mode = pmResidual, const unsigned threads_size = 1) {
+            const unsigned tasks_size = parallel_threads_size(threads_size);
+            communities_.assign(cnf.variables_size(), PARTITION_NO_COMMUNITY);
+            names_.clear();
+
+            const formula_named_variables_t& nv = cnf.get_named_variables();
+            for (formula_named_variables_t::const_iterator it = nv.begin(); it != nv.end(); ++it) {
+                const VariablesArray& nv_variables = it->second;
+                bool is_used = false;
+                for (uint32_t i = 0; i < nv_variables.size(); i++) {
+                    if (literal_t__is_variable(nv_variables.data()[i])) {
+                        const variableid_t variable_id = literal_t__variable_id(nv_variables.data()[i]);
+                        if (variable_id < communities_.size() && communities_[variable_id] == PARTITION_NO_COMMUNITY) {
+                            communities_[variable_id] = (uint32_t)names_.size();
+                            is_used = true;
+                        };
+                    };
+                };
+                if (is_used) {
+                    names_.push_back(it->first);
+                };
+            };
+
+            if (mode == pmNearest && !names_.empty()) {
+                unsigned rounds_size = 0;
+                while (rounds_size < PARTITION_NEAREST_ROUNDS_MAX && attach_nearest(cnf, tasks_size) > 0) {
+                    rounds_size++;
+                };
+            };
+
+            const uint32_t residual = (uint32_t)names_.size();
+            for (uint32_t& community: communities_) {
+                if (community == PARTITION_NO_COMMUNITY) {
+                    community = residual;
+                };
+            };
+            if (std::find(communities_.begin(), communities_.end(), residual) != communities_.end()) {
+                names_.push_back(std::string());
+            };
+        };
+
+        // community of each variable
+        const std::vector<uint32_t>& communities() const { return communities_; };
+        uint32_t communities_size() const { return (uint32_t)names_.size(); };
+        // name of the named variable, empty for the residual community
+        const std::string& name(const uint32_t community) const { return names_[community]; };
+    };
+
+    // modularity of a partition of the variable incidence graph, computed from the clauses in one pass
+    // without building the graph: a clause of size k contributes weight w = 2 * cardinality / (k * (k - 1))
+    // to each pair of its variables, as in VariableIncidenceGraph; the weights are linear, so edges
+    // that occur in several clauses need not be merged
+    // for a community c with n_c variables in the clause, the clause adds n_c * (n_c - 1) / 2 * w
+    // to the weight inside c and n_c * (k - 1) * w to the degrees of c
+    // Q = sum over communities of 2 * inner / 2m - (degrees / 2m)^2
+    class PartitionModularity {
+    private:
+        std::vector<double> inner_weights_;
+        std::vector<double> outer_weights_;
+        std::vector<uint32_t> variables_sizes_;
+        double total_weight_ = 0;
+        double modularity_ = 0;
+
+    public:
+        PartitionModularity() = default;
+
+        // communities[variable] < communities_size
+        // threads_size, see parallel_threads_size
+        void run(const Cnf& cnf, const std::vector<uint32_t>& communities, const uint32_t communities_size, const unsigned threads_size = 1) {
+            TraceSpan span(stPartition, "clauses");
+            const unsigned tasks_size = parallel_threads_size(threads_size);
+
+            std::vector<uint32_t> range_positions(PARTITION_RANGES_SIZE + 1);
+            std::vector<clauses_size_t> range_first_clauses(PARTITION_RANGES_SIZE + 1);
+            const clauses_size_t clauses_size = cnf.split_clauses(PARTITION_RANGES_SIZE, range_positions.data(), range_first_clauses.data());
+
+            // per range: inner weights of the communities followed by their degrees
+            std::vector<std::vector<double>> range_sums(PARTITION_RANGES_SIZE);
+            parallel_for(tasks_size, PARTITION_RANGES_SIZE, [&](const unsigned, const unsigned begin, const unsigned end) {
+                std::vector<uint32_t> clause_communities;
+                for (unsigned range = begin; range < end; range++) {
+                    std::vector<double>& sums = range_sums[range];
+                    sums.assign(communities_size * 2, 0);
+                    cnf.for_each_clause(range_positions[range], range_positions[range + 1], [&](const uint32_t* const p_clause) {
+                        const clause_size_t clause_size = _clause_size(p_clause);
+                        if (clause_size < 2) {
+                            return;
+                        };
+                        const double weight = 2.0 * get_clause_header_cardinality(*p_clause) / clause_size / (clause_size - 1);
+                        clause_communities.clear();
+                        for (clause_size_t i = 0; i < clause_size; i++) {
+                            clause_communities.push_back(communities[literal_t__variable_id(_clause_literal(p_clause, i))]);
+                        };
+                        std::sort(clause_communities.begin(), clause_communities.end());
+                        for (size_t i = 0; i < clause_communities.size(); ) {
+                            const uint32_t community = clause_communities[i];
+                            size_t size = 0;
+                            for (; i < clause_communities.size() && clause_communities[i] == community; i++) {
+                                size++;
+                            };
+                            sums[community] += size * (size - 1) / 2 * weight;
+                            sums[communities_size + community] += size * (clause_size - 1) * weight;
+                        };
+                    });
+                };
+            });
+
+            inner_weights_.assign(communities_size, 0);
+            std::vector<double> degrees(communities_size, 0);
+            for (const std::vector<double>& sums: range_sums) {
+                for (uint32_t c = 0; c < communities_size; c++) {
+                    inner_weights_[c] += sums[c];
+                    degrees[c] += sums[communities_size + c];
+                };
+            };
+            variables_sizes_.assign(communities_size, 0);
+            for (const uint32_t community: communities) {
+                variables_sizes_[community]++;
+            };
+
+            total_weight_ = 0;
+            for (const double degree: degrees) {
+                total_weight_ += degree;
+            };
+            outer_weights_.resize(communities_size);
+            modularity_ = 0;
+            for (uint32_t c = 0; c < communities_size; c++) {
+                // the edges leaving the community, each inner edge adds to the degrees twice
+                outer_weights_[c] = std::max(0.0, degrees[c] - 2 * inner_weights_[c]);
+                if (total_weight_ > 0) {
+                    modularity_ += 2 * inner_weights_[c] / total_weight_ - (degrees[c] / total_weight_) * (degrees[c] / total_weight_);
+                };
+            };
+            span.set_items(clauses_size);
+        };
+
+        double modularity() const { return modularity_; };
+        // the weight of the edges within the community
+        const std::vector<double>& inner_weights() const { return inner_weights_; };
+        // the weight of the edges between the community and the others
+        const std::vector<double>& outer_weights() const { return outer_weights_; };
+        const std::vector<uint32_t>& variables_sizes() const { return variables_sizes_; };
+        // the weight of all edges, doubled: 2m
+        double total_weight() const { return total_weight_; };
+    };
+};
+
+#endif /* partitionmodularity_hpp */
@@ -0,0 +1,230 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef variableincidencegraph_hpp
+#define variableincidencegraph_hpp
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "cnf.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+
+namespace bal {
+
+    static const constexpr uint32_t VIG_NO_LABEL = UINT32_MAX;
+
+    // undirected graph with a node per variable and an edge between any two variables
+    // occurring in the same clause; node IDs are variable IDs, i.e. DIMACS numbers less one
+    // adjacency is stored in CSR form: neighbours of a node follow each other sorted ascending,
+    // each edge is present in the rows of both of its nodes
+    // each edge carries the number of clauses it comes from (cardinality) and its weight,
+    // the sum of 2 / (clause_size * (clause_size - 1)) over these clauses
+    // an aggregated clause, of up to 4 literals, counts as the clauses it stands for
+    class VariableIncidenceGraph {
+    public:
+        typedef uint64_t edge_offset_t;
+
+    private:
+        variables_size_t nodes_size_ = 0;
+        // row of node i is [offsets_[i], offsets_[i + 1])
+        std::vector<edge_offset_t> offsets_;
+        std::vector<variableid_t> neighbours_;
+        std::vector<uint32_t> cardinalities_;
+        std::vector<double> weights_;
+
+        // node label is the first named variable the node belongs to, if any
+        std::vector<std::string> label_names_;
+        std::vector<uint32_t> label_name_indexes_;
+        std::vector<uint32_t> label_indexes_;
+
+        void build_labels(const Cnf& cnf) {
+            label_names_.clear();
+            label_name_indexes_.assign(nodes_size_, VIG_NO_LABEL);
+            label_indexes_.assign(nodes_size_, 0);
+
+            const formula_named_variables_t& nv = cnf.get_named_variables();
+            for (formula_named_variables_t::const_iterator it = nv.begin(); it != nv.end(); ++it) {
+                const VariablesArray& nv_variables = it->second;
+                bool is_used = false;
+                for (uint32_t i = 0; i < nv_variables.size(); i++) {
+                    if (literal_t__is_variable(nv_variables.data()[i])) {
+                        const variableid_t variable_id = literal_t__variable_id(nv_variables.data()[i]);
+                        if (variable_id < nodes_size_ && label_name_indexes_[variable_id] == VIG_NO_LABEL) {
+                            label_name_indexes_[variable_id] = (uint32_t)label_names_.size();
+                            label_indexes_[variable_id] = i;
+                            is_used = true;
+                        };
+                    };
+                };
+                if (is_used) {
+                    label_names_.push_back(it->first);
+                };
+            };
+        };
+
+    public:
+        VariableIncidenceGraph() = default;
+
+        VariableIncidenceGraph(const Cnf& cnf, const unsigned threads_size = 1) {
+            build(cnf, threads_size);
+        };
+
+        // threads_size, see parallel_threads_size
+        // the result does not depend on the number of threads
+        void build(const Cnf& cnf, const unsigned threads_size = 1) {
+            TraceSpan span(stEdges, "edges");
+            const unsigned tasks_size = parallel_threads_size(threads_size);
+            nodes_size_ = cnf.variables_size();
+
+            // clauses are numbered in their order
+            std::vector<uint32_t> range_positions(tasks_size + 1);
+            std::vector<clauses_size_t> range_first_clauses(tasks_size + 1);
+            const clauses_size_t clauses_size = cnf.split_clauses(tasks_size, range_positions.data(), range_first_clauses.data());
+
+            // pass 1: each clause of size k contributes k - 1 entries to the row of each of its variables
+            std::vector<std::atomic<edge_offset_t>> positions(nodes_size_ + 1);
+            std::vector<edge_offset_t> entries_offsets(nodes_size_ + 1, 0);
+            std::vector<uint32_t> clause_headers(clauses_size);
+            parallel_execute(tasks_size, [&](const unsigned index) {
+                uint32_t clause_index = range_first_clauses[index];
+                cnf.for_each_clause(range_positions[index], range_positions[index + 1], [&](const uint32_t* const p_clause) {
+                    const clause_size_t clause_size = _clause_size(p_clause);
+                    clause_headers[clause_index++] = *p_clause;
+                    for (clause_size_t i = 0; clause_size > 1 && i < clause_size; i++) {
+                        const variableid_t variable_id = literal_t__variable_id(_clause_literal(p_clause, i));
+                        positions[variable_id].fetch_add(clause_size - 1, std::memory_order_relaxed);
+                    };
+                });
+            });
+
+            // pass 2: row offsets for the entries, including duplicate neighbours
+            parallel_for(tasks_size, nodes_size_, [&](const unsigned, const variableid_t begin, const variableid_t end) {
+                for (variableid_t i = begin; i < end; i++) {
+                    entries_offsets[i] = positions[i].load(std::memory_order_relaxed);
+                };
+            });
+            const edge_offset_t entries_size = parallel_exclusive_scan(tasks_size, entries_offsets.data(), nodes_size_);
+            entries_offsets[nodes_size_] = entries_size;
+            parallel_for(tasks_size, nodes_size_, [&](const unsigned, const variableid_t begin, const variableid_t end) {
+                for (variableid_t i = begin; i < end; i++) {
+                    positions[i].store(entries_offsets[i], std::memory_order_relaxed);
+                };
+            });
+
+            // pass 3: fill the rows; an entry is the neighbour in the high half and the clause number in the low one
+            // the order within a row depends on the threads, it is fixed by sorting next
+            std::vector<uint64_t> entries(entries_size);
+            parallel_execute(tasks_size, [&](const unsigned index) {
+                uint32_t clause_index = range_first_clauses[index];
+                cnf.for_each_clause(range_positions[index], range_positions[index + 1], [&](const uint32_t* const p_clause) {
+                    const clause_size_t clause_size = _clause_size(p_clause);
+                    for (clause_size_t i = 0; i < clause_size; i++) {
+                        const variableid_t source = literal_t__variable_id(_clause_literal(p_clause, i));
+                        for (clause_size_t j = i + 1; j < clause_size; j++) {
+                            const variableid_t target = literal_t__variable_id(_clause_literal(p_clause, j));
+                            entries[positions[source].fetch_add(1, std::memory_order_relaxed)] = ((uint64_t)target << 32) | clause_index;
+                            entries[positions[target].fetch_add(1, std::memory_order_relaxed)] = ((uint64_t)source << 32) | clause_index;
+                        };
+                    };
+                    clause_index++;
+                });
+            });
+            positions.clear();
+            positions.shrink_to_fit();
+
+            // pass 4: sort each row by neighbour then clause number, count distinct neighbours
+            offsets_.assign(nodes_size_ + 1, 0);
+            parallel_for(tasks_size, nodes_size_, [&](const unsigned, const variableid_t begin, const variableid_t end) {
+                for (variableid_t i = begin; i < end; i++) {
+                    uint64_t* const row = entries.data() + entries_offsets[i];
+                    uint64_t* const row_end = entries.data() + entries_offsets[i + 1];
+                    std::sort(row, row_end);
+                    edge_offset_t degree = 0;
+                    for (const uint64_t* p = row; p < row_end; p++) {
+                        if (p == row || (p[0] >> 32) != (p[-1] >> 32)) {
+                            degree++;
+                        };
+                    };
+                    offsets_[i] = degree;
+                };
+            });
+            const edge_offset_t size = parallel_exclusive_scan(tasks_size, offsets_.data(), nodes_size_);
+            offsets_[nodes_size_] = size;
+
+            // pass 5: merge duplicate neighbours; weights are summed in the order of clauses
+            // so that the result is exactly the same whatever the number of threads
+            neighbours_.resize(size);
+            cardinalities_.resize(size);
+            weights_.resize(size);
+            parallel_for(tasks_size, nodes_size_, [&](const unsigned, const variableid_t begin, const variableid_t end) {
+                for (variableid_t i = begin; i < end; i++) {
+                    edge_offset_t offset = offsets_[i];
+                    const uint64_t* const row = entries.data() + entries_offsets[i];
+                    const uint64_t* const row_end = entries.data() + entries_offsets[i + 1];
+                    for (const uint64_t* p = row; p < row_end; p++) {
+                        const uint32_t header = clause_headers[(uint32_t)*p];
+                        const clause_size_t clause_size = _clause_header_size(header);
+                        const uint32_t cardinality = get_clause_header_cardinality(header);
+                        const double weight = 2.0 * cardinality / clause_size / (clause_size - 1);
+                        if (p == row || (p[0] >> 32) != (p[-1] >> 32)) {
+                            neighbours_[offset] = (variableid_t)(*p >> 32);
+                            cardinalities_[offset] = cardinality;
+                            weights_[offset] = weight;
+                            offset++;
+                        } else {
+                            cardinalities_[offset - 1] += cardinality;
+                            weights_[offset - 1] += weight;
+                        };
+                    };
+                };
+            });
+
+            build_labels(cnf);
+            span.set_items(edges_size());
+        };
+
+        variables_size_t nodes_size() const { return nodes_size_; };
+        // number of undirected edges
+        edge_offset_t edges_size() const { return neighbours_.size() / 2; };
+
+        edge_offset_t degree(const variableid_t node) const { return offsets_[node + 1] - offsets_[node]; };
+        // row boundaries, for the node and the next one; offsets().size() == nodes_size() + 1
+        const std::vector<edge_offset_t>& offsets() const { return offsets_; };
+        // indexed by edge offsets
+        const std::vector<variableid_t>& neighbours() const { return neighbours_; };
+        const std::vector<uint32_t>& cardinalities() const { return cardinalities_; };
+        const std::vector<double>& weights() const { return weights_; };
+
+        bool has_label(const variableid_t node) const { return label_name_indexes_[node] != VIG_NO_LABEL; };
+        // name and index within the named variable; valid if has_label(node)
+        const std::string& label_name(const variableid_t node) const { return label_names_[label_name_indexes_[node]]; };
+        uint32_t label_index(const variableid_t node) const { return label_indexes_[node]; };
+
+        // calls f(source, target, offset) for each edge once, source < target
+        // edges are ordered by target then source; offset refers to the edge in the row of target
+        template<typename F>
+        void for_each_edge(F f) const {
+            for (variableid_t target = 0; target < nodes_size_; target++) {
+                for (edge_offset_t offset = offsets_[target]; offset < offsets_[target + 1] && neighbours_[offset] < target; offset++) {
+                    f(neighbours_[offset], target, offset);
+                };
+            };
+        };
+
+        size_t memory_size() const {
+            return offsets_.size() * sizeof(edge_offset_t) + neighbours_.size() * sizeof(variableid_t) +
+                cardinalities_.size() * sizeof(uint32_t) + weights_.size() * sizeof(double) +
+                label_name_indexes_.size() * sizeof(uint32_t) + label_indexes_.size() * sizeof(uint32_t);
+        };
+    };
+};
+
+#endif /* variableincidencegraph_hpp */
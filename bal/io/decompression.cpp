@@ -0,0 +1,460 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#include "decompression.hpp"
+
+#include <string.h>
+#include <stdexcept>
+
+#ifdef BAL_ZLIB
+#include <zlib.h>
+#endif
+#ifdef BAL_LZMA
+#include <lzma.h>
+#endif
+#ifdef BAL_ZSTD
+#include <zstd.h>
+#endif
+
+namespace bal {
+
+    Compression compression_detect(const char* const data, const size_t size) {
+        static const unsigned char GZIP_MAGIC[] = {0x1F, 0x8B};
+        static const unsigned char XZ_MAGIC[] = {0xFD, '7', 'z', 'X', 'Z', 0x00};
+        static const unsigned char ZSTD_MAGIC[] = {0x28, 0xB5, 0x2F, 0xFD};
+        if (size >= sizeof(GZIP_MAGIC) && memcmp(data, GZIP_MAGIC, sizeof(GZIP_MAGIC)) == 0) {
+            return cmGzip;
+        } else if (size >= sizeof(XZ_MAGIC) && memcmp(data, XZ_MAGIC, sizeof(XZ_MAGIC)) == 0) {
+            return cmXz;
+        } else if (size >= sizeof(ZSTD_MAGIC) && memcmp(data, ZSTD_MAGIC, sizeof(ZSTD_MAGIC)) == 0) {
+            return cmZstd;
+        };
+        return cmNone;
+    };
+
+    bool compression_is_supported(const Compression compression) {
+        switch (compression) {
+            case cmNone:
+                return true;
+#ifdef BAL_ZLIB
+            case cmGzip:
+                return true;
+#endif
+#ifdef BAL_LZMA
+            case cmXz:
+                return true;
+#endif
+#ifdef BAL_ZSTD
+            case cmZstd:
+                return true;
+#endif
+            default:
+                return false;
+        };
+    };
+
+    const char* compression_name(const Compression compression) {
+        switch (compression) {
+            case cmNone: return "none";
+            case cmGzip: return "gzip";
+            case cmXz: return "xz";
+            case cmZstd: return "zstd";
+        };
+        return "unknown";
+    };
+
+    // compressed content in pieces of any size
+    class DecompressionStreamBuf::Source {
+    public:
+        virtual ~Source() {};
+        // returns false at the end of the content
+        virtual bool next(const char*& data, size_t& size) = 0;
+    };
+
+    namespace {
+
+        class MemorySource: public DecompressionStreamBuf::Source {
+        private:
+            // codecs take the input size as a 32 bit value
+            static const size_t constexpr PIECE_SIZE_MAX = 1 << 30;
+            const char* data_;
+            const char* const data_end_;
+
+        public:
+            MemorySource(const char* const data, const size_t size): data_(data), data_end_(data + size) {};
+
+            virtual bool next(const char*& data, size_t& size) override {
+                if (data_ >= data_end_) {
+                    return false;
+                };
+                data = data_;
+                size = (size_t)(data_end_ - data_) < PIECE_SIZE_MAX ? data_end_ - data_ : PIECE_SIZE_MAX;
+                data_ += size;
+                return true;
+            };
+        };
+
+        class StreamSource: public DecompressionStreamBuf::Source {
+        private:
+            static const size_t constexpr PIECE_SIZE = 1 << 18;
+            std::istream& stream_;
+            // holds the prefix first, then the last piece read
+            std::vector<char> buffer_;
+            bool is_prefix_ = true;
+
+        public:
+            StreamSource(std::istream& stream, const char* const prefix, const size_t prefix_size):
+                stream_(stream), buffer_(prefix, prefix + prefix_size) {};
+
+            virtual bool next(const char*& data, size_t& size) override {
+                if (is_prefix_) {
+                    is_prefix_ = false;
+                    if (!buffer_.empty()) {
+                        data = buffer_.data();
+                        size = buffer_.size();
+                        return true;
+                    };
+                };
+                buffer_.resize(PIECE_SIZE);
+                stream_.read(buffer_.data(), buffer_.size());
+                data = buffer_.data();
+                size = (size_t)stream_.gcount();
+                return size > 0;
+            };
+        };
+
+        // produces the decompressed content in pieces, throws std::runtime_error if the content is broken
+        class Decoder {
+        private:
+            std::string error_;
+
+        protected:
+            DecompressionStreamBuf::Source& source_;
+            const char* input_ = nullptr;
+            size_t input_size_ = 0;
+            bool is_input_end_ = false;
+            // number of bytes written to the output by the current decode_ call so far
+            size_t progress_ = 0;
+
+            // keeps input_ non-empty unless the content is over
+            void fetch_input() {
+                if (input_size_ == 0 && !is_input_end_) {
+                    is_input_end_ = !source_.next(input_, input_size_);
+                    if (is_input_end_) {
+                        input_ = nullptr;
+                        input_size_ = 0;
+                    };
+                };
+            };
+
+            // returns the number of bytes written to output, 0 at the end of the content
+            virtual size_t decode_(char* const output, const size_t output_size) = 0;
+
+        public:
+            Decoder(DecompressionStreamBuf::Source& source): source_(source) {};
+            virtual ~Decoder() {};
+
+            // the content decoded ahead of an error is returned first, the error is thrown by the next call
+            size_t decode(char* const output, const size_t output_size) {
+                if (!error_.empty()) {
+                    throw std::runtime_error(error_);
+                };
+                progress_ = 0;
+                try {
+                    return decode_(output, output_size);
+                }
+                catch (const std::runtime_error& e) {
+                    if (progress_ == 0) {
+                        throw;
+                    };
+                    error_ = e.what();
+                    return progress_;
+                };
+            };
+        };
+
+        class CopyDecoder: public Decoder {
+        public:
+            CopyDecoder(DecompressionStreamBuf::Source& source): Decoder(source) {};
+
+            virtual size_t decode_(char* const output, const size_t output_size) override {
+                size_t result = 0;
+                while (result < output_size) {
+                    fetch_input();
+                    if (input_size_ == 0) {
+                        break;
+                    };
+                    const size_t size = input_size_ < output_size - result ? input_size_ : output_size - result;
+                    memcpy(output + result, input_, size);
+                    input_ += size;
+                    input_size_ -= size;
+                    result += size;
+                };
+                return result;
+            };
+        };
+
+#ifdef BAL_ZLIB
+        class GzipDecoder: public Decoder {
+        private:
+            z_stream stream_;
+            bool is_stream_end_ = false;
+
+        public:
+            GzipDecoder(DecompressionStreamBuf::Source& source): Decoder(source) {
+                memset(&stream_, 0, sizeof(stream_));
+                // 32 enables the gzip header detection
+                if (inflateInit2(&stream_, 15 + 32) != Z_OK) {
+                    throw std::runtime_error("cannot initialize zlib");
+                };
+            };
+
+            virtual ~GzipDecoder() {
+                inflateEnd(&stream_);
+            };
+
+            virtual size_t decode_(char* const output, const size_t output_size) override {
+                stream_.next_out = (Bytef*)output;
+                stream_.avail_out = (uInt)output_size;
+                while (stream_.avail_out > 0) {
+                    fetch_input();
+                    // gzip files may consist of several members one after another
+                    if (is_stream_end_) {
+                        if (input_size_ == 0) {
+                            break;
+                        };
+                        inflateReset(&stream_);
+                        is_stream_end_ = false;
+                    };
+                    stream_.next_in = (Bytef*)input_;
+                    stream_.avail_in = (uInt)input_size_;
+                    const int result = inflate(&stream_, Z_NO_FLUSH);
+                    input_ = (const char*)stream_.next_in;
+                    input_size_ = stream_.avail_in;
+                    progress_ = output_size - stream_.avail_out;
+                    if (result == Z_STREAM_END) {
+                        is_stream_end_ = true;
+                    } else if (result == Z_BUF_ERROR) {
+                        // no progress is possible without more input
+                        if (is_input_end_) {
+                            throw std::runtime_error("unexpected end of gzip data");
+                        };
+                    } else if (result != Z_OK) {
+                        throw std::runtime_error(stream_.msg != nullptr ? stream_.msg : "broken gzip data");
+                    };
+                };
+                return output_size - stream_.avail_out;
+            };
+        };
+#endif
+
+#ifdef BAL_LZMA
+        class XzDecoder: public Decoder {
+        private:
+            lzma_stream stream_ = LZMA_STREAM_INIT;
+            bool is_stream_end_ = false;
+
+        public:
+            XzDecoder(DecompressionStreamBuf::Source& source): Decoder(source) {
+                if (lzma_stream_decoder(&stream_, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+                    throw std::runtime_error("cannot initialize liblzma");
+                };
+            };
+
+            virtual ~XzDecoder() {
+                lzma_end(&stream_);
+            };
+
+            virtual size_t decode_(char* const output, const size_t output_size) override {
+                stream_.next_out = (uint8_t*)output;
+                stream_.avail_out = output_size;
+                while (stream_.avail_out > 0 && !is_stream_end_) {
+                    fetch_input();
+                    stream_.next_in = (const uint8_t*)input_;
+                    stream_.avail_in = input_size_;
+                    const lzma_ret result = lzma_code(&stream_, is_input_end_ ? LZMA_FINISH : LZMA_RUN);
+                    input_ = (const char*)stream_.next_in;
+                    input_size_ = stream_.avail_in;
+                    progress_ = output_size - stream_.avail_out;
+                    if (result == LZMA_STREAM_END) {
+                        is_stream_end_ = true;
+                    } else if (result == LZMA_BUF_ERROR) {
+                        throw std::runtime_error("unexpected end of xz data");
+                    } else if (result != LZMA_OK) {
+                        throw std::runtime_error("broken xz data");
+                    };
+                };
+                return output_size - stream_.avail_out;
+            };
+        };
+#endif
+
+#ifdef BAL_ZSTD
+        class ZstdDecoder: public Decoder {
+        private:
+            ZSTD_DStream* stream_;
+            // 0 once a frame is completely decoded
+            size_t hint_ = 0;
+
+        public:
+            ZstdDecoder(DecompressionStreamBuf::Source& source): Decoder(source) {
+                stream_ = ZSTD_createDStream();
+                if (stream_ == nullptr || ZSTD_isError(ZSTD_initDStream(stream_))) {
+                    ZSTD_freeDStream(stream_);
+                    throw std::runtime_error("cannot initialize zstd");
+                };
+            };
+
+            virtual ~ZstdDecoder() {
+                ZSTD_freeDStream(stream_);
+            };
+
+            virtual size_t decode_(char* const output, const size_t output_size) override {
+                ZSTD_outBuffer output_buffer = {output, output_size, 0};
+                while (output_buffer.pos < output_buffer.size) {
+                    fetch_input();
+                    ZSTD_inBuffer input_buffer = {input_, input_size_, 0};
+                    const size_t output_pos = output_buffer.pos;
+                    const size_t result = ZSTD_decompressStream(stream_, &output_buffer, &input_buffer);
+                    progress_ = output_buffer.pos;
+                    if (ZSTD_isError(result)) {
+                        throw std::runtime_error(ZSTD_getErrorName(result));
+                    };
+                    input_ += input_buffer.pos;
+                    input_size_ -= input_buffer.pos;
+                    hint_ = result;
+                    // nothing is left either in the input or inside the decoder
+                    if (is_input_end_ && output_buffer.pos == output_pos) {
+                        if (hint_ != 0) {
+                            throw std::runtime_error("unexpected end of zstd data");
+                        };
+                        break;
+                    };
+                };
+                return output_buffer.pos;
+            };
+        };
+#endif
+
+        Decoder* create_decoder(const Compression compression, DecompressionStreamBuf::Source& source) {
+            switch (compression) {
+                case cmNone:
+                    return new CopyDecoder(source);
+#ifdef BAL_ZLIB
+                case cmGzip:
+                    return new GzipDecoder(source);
+#endif
+#ifdef BAL_LZMA
+                case cmXz:
+                    return new XzDecoder(source);
+#endif
+#ifdef BAL_ZSTD
+                case cmZstd:
+                    return new ZstdDecoder(source);
+#endif
+                default:
+                    throw std::runtime_error(std::string(compression_name(compression)) + " is not supported by this build");
+            };
+        };
+    };
+
+    DecompressionStreamBuf::DecompressionStreamBuf(const Compression compression, const char* const data, const size_t size):
+        source_(new MemorySource(data, size)), compression_(compression) {
+        thread_ = std::thread(&DecompressionStreamBuf::decompress, this);
+    };
+
+    DecompressionStreamBuf::DecompressionStreamBuf(const Compression compression, std::istream& stream,
+                                                   const char* const prefix, const size_t prefix_size):
+        source_(new StreamSource(stream, prefix, prefix_size)), compression_(compression) {
+        thread_ = std::thread(&DecompressionStreamBuf::decompress, this);
+    };
+
+    DecompressionStreamBuf::~DecompressionStreamBuf() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            is_cancelled_ = true;
+        };
+        condition_.notify_all();
+        thread_.join();
+        delete source_;
+    };
+
+    std::string DecompressionStreamBuf::error() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return error_;
+    };
+
+    // waits for room in the queue, returns false if the reader is gone
+    bool DecompressionStreamBuf::push_block(std::vector<char>& block) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]() { return is_cancelled_ || blocks_.size() < BLOCKS_SIZE_MAX; });
+        if (is_cancelled_) {
+            return false;
+        };
+        blocks_.push_back(std::move(block));
+        if (!free_blocks_.empty()) {
+            block = std::move(free_blocks_.back());
+            free_blocks_.pop_back();
+        };
+        condition_.notify_all();
+        return true;
+    };
+
+    void DecompressionStreamBuf::decompress() {
+        std::string error;
+        try {
+            Decoder* decoder = create_decoder(compression_, *source_);
+            try {
+                std::vector<char> block;
+                while (true) {
+                    block.resize(BLOCK_SIZE);
+                    const size_t size = decoder->decode(block.data(), block.size());
+                    if (size == 0) {
+                        break;
+                    };
+                    block.resize(size);
+                    if (!push_block(block)) {
+                        break;
+                    };
+                };
+            }
+            catch (...) {
+                delete decoder;
+                throw;
+            };
+            delete decoder;
+        }
+        catch (const std::exception& e) {
+            error = e.what();
+        };
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = error;
+        is_finished_ = true;
+        condition_.notify_all();
+    };
+
+    DecompressionStreamBuf::int_type DecompressionStreamBuf::underflow() {
+        if (gptr() < egptr()) {
+            return traits_type::to_int_type(*gptr());
+        };
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (block_.capacity() > 0) {
+            free_blocks_.push_back(std::move(block_));
+            block_.clear();
+        };
+        condition_.wait(lock, [this]() { return is_finished_ || !blocks_.empty(); });
+        if (blocks_.empty()) {
+            setg(nullptr, nullptr, nullptr);
+            return traits_type::eof();
+        };
+        block_ = std::move(blocks_.front());
+        blocks_.pop_front();
+        condition_.notify_all();
+        setg(block_.data(), block_.data(), block_.data() + block_.size());
+        return traits_type::to_int_type(*gptr());
+    };
+};
@@ -0,0 +1,81 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef decompression_hpp
+#define decompression_hpp
+
+#include <stddef.h>
+#include <condition_variable>
+#include <deque>
+#include <istream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bal {
+
+    // supported codecs depend on the libraries found at build time, see CMakeLists.txt
+    enum Compression {cmNone, cmGzip, cmXz, cmZstd};
+
+    // number of leading bytes sufficient to detect any of the supported formats
+    static const size_t constexpr COMPRESSION_MAGIC_SIZE_MAX = 6;
+
+    // detects the format by its magic bytes; cmNone if none matches
+    Compression compression_detect(const char* const data, const size_t size);
+    bool compression_is_supported(const Compression compression);
+    const char* compression_name(const Compression compression);
+
+    // stream buffer returning the decompressed content of either a memory buffer or a stream
+    // decompression runs on its own thread, a few blocks ahead of the reader
+    // cmNone passes the content through unchanged, still reading ahead on the thread
+    // decompression errors end the content early; error() tells them apart from the normal end
+    class DecompressionStreamBuf: public std::streambuf {
+    public:
+        class Source;
+
+    private:
+        static const size_t constexpr BLOCK_SIZE = 1 << 20;
+        static const size_t constexpr BLOCKS_SIZE_MAX = 4;
+
+        Source* source_;
+        Compression compression_;
+        std::thread thread_;
+
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        std::deque<std::vector<char>> blocks_;
+        std::vector<std::vector<char>> free_blocks_;
+        bool is_finished_ = false;
+        bool is_cancelled_ = false;
+        std::string error_;
+
+        std::vector<char> block_;
+
+        void decompress();
+        bool push_block(std::vector<char>& block);
+
+    protected:
+        virtual int_type underflow() override;
+
+    public:
+        // the buffer must remain available until the object is destroyed
+        DecompressionStreamBuf(const Compression compression, const char* const data, const size_t size);
+        // prefix holds the bytes already taken from the stream to detect the format
+        DecompressionStreamBuf(const Compression compression, std::istream& stream,
+                               const char* const prefix, const size_t prefix_size);
+        DecompressionStreamBuf(const DecompressionStreamBuf&) = delete;
+        DecompressionStreamBuf& operator = (const DecompressionStreamBuf&) = delete;
+        virtual ~DecompressionStreamBuf();
+
+        // empty unless decompression failed; valid once the content is read to the end
+        std::string error();
+    };
+};
+
+#endif /* decompression_hpp */
@@ -0,0 +1,80 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef mappedfile_hpp
+#define mappedfile_hpp
+
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace bal {
+
+    // memory mapping of a whole regular file, read only unless is_private_writable;
+    // the latter allows writing to the mapped pages without changing the file
+    // the mapping is released when the object is destroyed
+    class MappedFile {
+    private:
+        int fd_ = -1;
+        void* data_ = nullptr;
+        size_t size_ = 0;
+
+    public:
+        MappedFile() = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator = (const MappedFile&) = delete;
+
+        inline ~MappedFile() {
+            close();
+        };
+
+        // returns false if the file is not a regular non-empty file or cannot be mapped
+        // the caller is expected to fall back to the stream based access then
+        inline bool open(const char* const file_name, const bool is_private_writable = false) {
+            close();
+            fd_ = ::open(file_name, O_RDONLY);
+            if (fd_ != -1) {
+                struct stat file_stat;
+                if (fstat(fd_, &file_stat) == 0 && S_ISREG(file_stat.st_mode) && file_stat.st_size > 0) {
+                    void* data = mmap(nullptr, (size_t)file_stat.st_size, is_private_writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                                      MAP_PRIVATE, fd_, 0);
+                    if (data != MAP_FAILED) {
+                        data_ = data;
+                        size_ = (size_t)file_stat.st_size;
+                        // the file is expected to be read once from the beginning to the end
+                        madvise(data_, size_, MADV_SEQUENTIAL);
+                        return true;
+                    };
+                };
+                close();
+            };
+            return false;
+        };
+
+        inline void close() {
+            if (data_ != nullptr) {
+                munmap(data_, size_);
+                data_ = nullptr;
+                size_ = 0;
+            };
+            if (fd_ != -1) {
+                ::close(fd_);
+                fd_ = -1;
+            };
+        };
+
+        inline bool is_open() const { return data_ != nullptr; };
+        inline const char* data() const { return (const char*)data_; };
+        // valid if opened as is_private_writable
+        inline char* data() { return (char*)data_; };
+        inline size_t size() const { return size_; };
+    };
+};
+
+#endif /* mappedfile_hpp */
@@ -8,8 +8,13 @@
 #ifndef streamable_hpp
 #define streamable_hpp
 
+#include <algorithm>
 #include <sstream>
+#include <vector>
+#include <string.h>
+#include "parallel.hpp"
 #include "textreader.hpp"
+#include "textwriter.hpp"
 
 namespace bal {
 
@@ -40,16 +45,106 @@ namespace bal {
         virtual void write(const T& value) = 0;
     };
     
+    // writes text through a TextWriter buffer on top of the stream
+    // descendants must flush() once done, the buffer is also flushed when destroyed
+    template <typename T>
+    class TextStreamWriter: public StreamWriter<T> {
+    private:
+        TextWriter out_;
+        std::vector<TextWriter> chunks_;
+        
+    protected:
+        // items per chunk, chunks of all threads are formatted before any of them is written
+        static const constexpr size_t CHUNK_ITEMS_SIZE = 1 << 16;
+        
+        TextWriter& out() { return out_; };
+        
+        // calls format(out, begin, end) to format items [begin, end) of [0, size) into out
+        // with several tasks, chunks are formatted in parallel each into its own buffer, then
+        // the buffers are written in order, so the output does not depend on the number of tasks
+        // chunk_items_size is the number of items a chunk takes, fewer for larger items
+        template<typename F>
+        void write_parallel(const unsigned tasks_size, const size_t size, F format,
+                            const size_t chunk_items_size = CHUNK_ITEMS_SIZE) {
+            if (tasks_size <= 1 || size <= chunk_items_size) {
+                format(out_, 0, size);
+                return;
+            };
+            if (chunks_.size() != tasks_size) {
+                chunks_ = std::vector<TextWriter>(tasks_size);
+            };
+            const size_t round_size = chunk_items_size * tasks_size;
+            for (size_t round_begin = 0; round_begin < size; round_begin += round_size) {
+                const size_t round_end = std::min(size, round_begin + round_size);
+                parallel_for(tasks_size, round_end - round_begin, [&](const unsigned index, const size_t begin, const size_t end) {
+                    chunks_[index].clear();
+                    format(chunks_[index], round_begin + begin, round_begin + end);
+                });
+                for (auto& chunk: chunks_) {
+                    out_.write(chunk.data(), chunk.buffered_size());
+                    chunk.clear();
+                };
+            };
+        };
+        
+    public:
+        TextStreamWriter(std::ostream& stream): StreamWriter<T>(stream), out_(stream) {};
+        
+        void flush() { out_.flush(); };
+        // number of symbols written so far
+        size_t written_size() const { return out_.size(); };
+    };
+    
+    // reads text line by line either from the stream or, if supplied, from the memory buffer
+    // the buffer is expected to hold the whole content of the stream e.g. a memory mapped file;
+    // lines are then returned in place without copying
     template <typename T>
     class TextStreamReader: public StreamReader<T>, public virtual TextReader {
+    private:
+        std::string line_;
+        const char* buffer_begin_ = nullptr;
+        const char* buffer_ = nullptr;
+        const char* buffer_end_ = nullptr;
+        
     protected:
         using TextReader::is_eof;
-        virtual bool is_eof_() override { return StreamReader<T>::is_eof(); };
-        virtual void getline(std::string& str) override { std::getline(StreamReader<T>::stream(), str); };
+        
+        virtual bool is_eof_() override {
+            return buffer_ != nullptr ? buffer_ >= buffer_end_ : StreamReader<T>::is_eof();
+        };
+        
+        virtual void getline(const char*& line, size_t& line_size) override {
+            if (buffer_ != nullptr) {
+                const char* eol = (const char*)memchr(buffer_, '\n', buffer_end_ - buffer_);
+                if (eol == nullptr) {
+                    eol = buffer_end_;
+                };
+                line = buffer_;
+                line_size = eol - buffer_;
+                buffer_ = eol < buffer_end_ ? eol + 1 : buffer_end_;
+            } else {
+                std::getline(StreamReader<T>::stream(), line_);
+                line = line_.data();
+                line_size = line_.size();
+            };
+        };
+        
+        inline bool is_buffered() const { return buffer_ != nullptr; };
+        inline const char* get_buffer_end() const { return buffer_end_; };
+        inline size_t get_buffer_size() const { return buffer_end_ - buffer_begin_; };
+        // bytes consumed so far, including the current line
+        inline size_t get_buffer_offset() const { return buffer_ - buffer_begin_; };
+        
+        // moves to the end of the buffer, the rest of it is processed externally
+        inline void skip_buffer() {
+            buffer_ = buffer_end_;
+            skip_line();
+        };
         
     public:
         TextStreamReader(std::istream& stream): StreamReader<T>(stream) {};
-        
+        TextStreamReader(std::istream& stream, const char* const buffer, const size_t buffer_size):
+            StreamReader<T>(stream), buffer_begin_(buffer), buffer_(buffer), buffer_end_(buffer + buffer_size) {};
     };
     
 };
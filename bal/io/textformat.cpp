@@ -0,0 +1,122 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#include "textformat.hpp"
+
+#include <math.h>
+#include <stdio.h>
+
+namespace bal {
+
+    // exactly representable powers of 10
+    static const double POWERS_OF_10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    static const constexpr int POWER_OF_10_MAX = 22;
+
+    // %g shows this many significant digits by default
+    static const constexpr int PRECISION = 6;
+
+    // value * 10^power with a single rounding; the power must be within the table either way
+    static inline double scale(const double value, const int power) {
+        return power >= 0 ? value * POWERS_OF_10[power] : value / POWERS_OF_10[-power];
+    };
+
+    // finds the digits from the scaled value directly, works for the vast majority of values
+    // returns false if the value is too large or small for the table, or if the scaled value
+    // is too close to the rounding boundary for its computation error to be ignored
+    static bool format_digits(const double value, uint32_t& digits, int& exponent) {
+        static const double DIGITS_MIN = 100000.0;  // 10^(PRECISION - 1)
+        static const double DIGITS_MAX = 1000000.0; // 10^PRECISION
+
+        exponent = (int)floor(log10(value));
+        for (int attempt = 0; attempt < 2; attempt++) {
+            const int power = PRECISION - 1 - exponent;
+            if (power > POWER_OF_10_MAX || power < -POWER_OF_10_MAX) {
+                return false;
+            };
+            const double scaled = scale(value, power);
+            const double rounded = floor(scaled + 0.5);
+            if (rounded < DIGITS_MIN) {
+                exponent--;
+            } else if (rounded >= DIGITS_MAX) {
+                exponent++;
+            } else {
+                // the scaled value is off by about one unit in the last place of the product
+                if (fabs(scaled - floor(scaled) - 0.5) < 1e-7) {
+                    return false;
+                };
+                digits = (uint32_t)rounded;
+                return true;
+            };
+        };
+        return false;
+    };
+
+    size_t text_format_double(char* const buffer, const double value) {
+        uint32_t digits;
+        int exponent;
+        if (!isfinite(value) || value == 0.0 || !format_digits(fabs(value), digits, exponent)) {
+            return (size_t)snprintf(buffer, TEXT_FORMAT_DOUBLE_SIZE_MAX, "%g", value);
+        };
+
+        char* p = buffer;
+        if (value < 0) {
+            *p++ = '-';
+        };
+
+        // significant digits without trailing zeros
+        char significant[PRECISION];
+        int significant_size = PRECISION;
+        for (int i = PRECISION - 1; i >= 0; i--) {
+            significant[i] = (char)('0' + digits % 10);
+            digits /= 10;
+        };
+        while (significant_size > 1 && significant[significant_size - 1] == '0') {
+            significant_size--;
+        };
+
+        if (exponent >= -4 && exponent < PRECISION) {
+            // fixed notation
+            if (exponent < 0) {
+                *p++ = '0';
+                *p++ = '.';
+                for (int i = -1; i > exponent; i--) {
+                    *p++ = '0';
+                };
+                memcpy(p, significant, significant_size);
+                p += significant_size;
+            } else {
+                for (int i = 0; i <= exponent; i++) {
+                    *p++ = i < significant_size ? significant[i] : '0';
+                };
+                if (significant_size > exponent + 1) {
+                    *p++ = '.';
+                    memcpy(p, significant + exponent + 1, significant_size - exponent - 1);
+                    p += significant_size - exponent - 1;
+                };
+            };
+        } else {
+            // scientific notation, at least 2 digits of exponent
+            *p++ = significant[0];
+            if (significant_size > 1) {
+                *p++ = '.';
+                memcpy(p, significant + 1, significant_size - 1);
+                p += significant_size - 1;
+            };
+            *p++ = 'e';
+            *p++ = exponent < 0 ? '-' : '+';
+            const unsigned exponent_abs = exponent < 0 ? -exponent : exponent;
+            if (exponent_abs < 10) {
+                *p++ = '0';
+            };
+            p += text_format_uint64(p, exponent_abs);
+        };
+        return p - buffer;
+    };
+};
@@ -0,0 +1,59 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef textformat_hpp
+#define textformat_hpp
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace bal {
+
+    // maximal number of symbols produced by the respective formatting function
+    static const constexpr size_t TEXT_FORMAT_UINT64_SIZE_MAX = 20;
+    static const constexpr size_t TEXT_FORMAT_INT64_SIZE_MAX = 20;
+    static const constexpr size_t TEXT_FORMAT_DOUBLE_SIZE_MAX = 32;
+
+    // decimal representation, two digits at a time; returns the number of symbols written
+    inline size_t text_format_uint64(char* const buffer, uint64_t value) {
+        static const char DIGITS[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+        char digits[TEXT_FORMAT_UINT64_SIZE_MAX];
+        char* p = digits + sizeof(digits);
+        while (value >= 100) {
+            const unsigned index = (unsigned)(value % 100) * 2;
+            value /= 100;
+            *--p = DIGITS[index + 1];
+            *--p = DIGITS[index];
+        };
+        if (value >= 10) {
+            *--p = DIGITS[value * 2 + 1];
+            *--p = DIGITS[value * 2];
+        } else {
+            *--p = (char)('0' + value);
+        };
+        const size_t size = digits + sizeof(digits) - p;
+        memcpy(buffer, p, size);
+        return size;
+    };
+
+    inline size_t text_format_int64(char* const buffer, const int64_t value) {
+        if (value < 0) {
+            buffer[0] = '-';
+            return text_format_uint64(buffer + 1, 0 - (uint64_t)value) + 1;
+        };
+        return text_format_uint64(buffer, (uint64_t)value);
+    };
+
+    // same as std::ostream produces with the default flags and precision, i.e. printf("%g")
+    size_t text_format_double(char* const buffer, const double value);
+};
+
+#endif /* textformat_hpp */
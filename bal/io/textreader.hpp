@@ -8,10 +8,12 @@
 #ifndef textreader_hpp
 #define textreader_hpp
 
+#include <assert.h>
 #include <string>
 #include <vector>
 #include <ostream>
 #include <stdint.h>
+#include "textscan.hpp"
 
 #define ERROR_BIN_INVALID_SYMBOL "Invalid symbol in binary value"
 #define ERROR_HEX_INVALID_SYMBOL "Invalid symbol in hexadecimal value"
@@ -45,10 +47,14 @@ private:
 public:
     TextReaderException(size_t line_index, size_t pos, std::string line, std::string message): line_index_(line_index), pos_(pos), line_(line), message_(message) {};
     
+    const size_t get_line_index() { return line_index_; };
     const size_t get_pos() { return pos_; };
     const char* const get_line() { return line_.c_str(); };
     const char* const get_message() { return message_.c_str(); };
     
+    // used when the text is parsed in fragments to make the line index absolute
+    void add_line_index_offset(const size_t value) { if (line_index_ > 0) line_index_ += value; };
+    
     friend std::ostream& operator << (std::ostream& stream, const TextReaderException &e) {
         stream << e.message_;
         if (e.line_index_ > 0) {
@@ -65,15 +71,21 @@ public:
 private:
     size_t current_token_pos_ = SIZE_MAX;
     size_t current_token_len_ = 0; // zero means token is not loaded
-    std::string current_line_ = "";
+    // the line is not owned by the reader, it remains valid until the next getline call
+    const char* current_line_ = "";
+    size_t current_line_size_ = 0;
     size_t current_line_index_ = 0;
     TokenType current_token_type_ = ttUnknown;
 
 protected:
     virtual bool is_eof_() = 0;
-    virtual void getline(std::string& str) = 0;
+    // returns the next line without the end of line symbol
+    virtual void getline(const char*& line, size_t& line_size) = 0;
     
-    const char* const get_current_token() { return current_line_.c_str() + current_token_pos_; };
+    const char* const get_current_token() { return current_line_ + current_token_pos_; };
+    const char* const get_current_line_data() { return current_line_; };
+    size_t get_current_line_size() { return current_line_size_; };
+    size_t get_current_line_index() { return current_line_index_; };
     size_t get_current_token_len() { return current_token_len_; };
     
 private:
@@ -84,10 +96,11 @@ private:
     
     inline void load_next_line() {
         if (!is_eof_()) {
-            getline(current_line_);
+            getline(current_line_, current_line_size_);
             current_line_index_ += 1;
         } else {
             current_line_ = "";
+            current_line_size_ = 0;
         };
         current_token_pos_ = 0;
         current_token_len_ = 0;
@@ -101,11 +114,11 @@ private:
     inline void parse_hex() {
         current_token_len_++;
         current_token_len_++;
-        while (current_token_pos_ + current_token_len_ < current_line_.size() &&
+        while (current_token_pos_ + current_token_len_ < current_line_size_ &&
                _is_hex_symbol(current_line_[current_token_pos_ + current_token_len_])) {
             current_token_len_++;
         };
-        if (current_token_pos_ + current_token_len_ < current_line_.size() &&
+        if (current_token_pos_ + current_token_len_ < current_line_size_ &&
             _is_literal_symbol(current_line_[current_token_pos_ + current_token_len_])) {
             parse_error(ERROR_HEX_INVALID_SYMBOL);
         } else if (current_token_len_ == 2) {
@@ -116,11 +129,11 @@ private:
     inline void parse_bin() {
         current_token_len_++;
         current_token_len_++;
-        while (current_token_pos_ + current_token_len_ < current_line_.size() &&
+        while (current_token_pos_ + current_token_len_ < current_line_size_ &&
                _is_bin_symbol(current_line_[current_token_pos_ + current_token_len_])) {
             current_token_len_++;
         };
-        if (current_token_pos_ + current_token_len_ < current_line_.size() &&
+        if (current_token_pos_ + current_token_len_ < current_line_size_ &&
             _is_literal_symbol(current_line_[current_token_pos_ + current_token_len_])) {
             parse_error(ERROR_BIN_INVALID_SYMBOL);
         } else if (current_token_len_ == 2) {
@@ -130,11 +143,9 @@ private:
     
     inline void parse_dec() {
         current_token_len_++;
-        while (current_token_pos_ + current_token_len_ < current_line_.size() &&
-               _is_dec_symbol(current_line_[current_token_pos_ + current_token_len_])) {
-            current_token_len_++;
-        };
-        if (current_token_pos_ + current_token_len_ < current_line_.size() &&
+        current_token_len_ += bal::text_scan_digits(current_line_ + current_token_pos_ + current_token_len_,
+                                               current_line_size_ - current_token_pos_ - current_token_len_);
+        if (current_token_pos_ + current_token_len_ < current_line_size_ &&
             _is_literal_symbol(current_line_[current_token_pos_ + current_token_len_])) {
             parse_error(ERROR_DEC_INVALID_SYMBOL);
         };
@@ -142,7 +153,7 @@ private:
     
     inline void parse_literal() {
         current_token_len_++;
-        while (current_token_pos_ + current_token_len_ < current_line_.size() &&
+        while (current_token_pos_ + current_token_len_ < current_line_size_ &&
                _is_literal_symbol(current_line_[current_token_pos_ + current_token_len_])) {
             current_token_len_++;
         };
@@ -150,11 +161,11 @@ private:
     
     inline void parse_quoted(const char quote_symbol) {
         current_token_len_++;
-        while (current_token_pos_ + current_token_len_ < current_line_.size() &&
+        while (current_token_pos_ + current_token_len_ < current_line_size_ &&
             (current_line_[current_token_pos_ + current_token_len_] != quote_symbol)) {
             current_token_len_++;
         };
-        if (current_token_pos_ + current_token_len_ < current_line_.size() &&
+        if (current_token_pos_ + current_token_len_ < current_line_size_ &&
             (current_line_[current_token_pos_ + current_token_len_] == quote_symbol)) {
             current_token_len_++;
         } else {
@@ -165,10 +176,10 @@ private:
     void load_next_token() {
         // current_token_len_ > 0 means the token is loaded already
         if (!is_eol() && current_token_len_ == 0) {
-            if (current_token_pos_ + current_token_len_ < current_line_.size()) {
+            if (current_token_pos_ + current_token_len_ < current_line_size_) {
                 switch(current_line_[current_token_pos_ + current_token_len_]) {
                     case '0':
-                        if (current_token_pos_ + current_token_len_ + 1 < current_line_.size()) {
+                        if (current_token_pos_ + current_token_len_ + 1 < current_line_size_) {
                             switch(current_line_[current_token_pos_ + current_token_len_ + 1]) {
                                 case 'x':
                                 case 'X':
@@ -221,11 +232,12 @@ private:
     
 public:
     void parse_error(std::string message) {
-        TextReaderException exception(current_line_index_, current_token_pos_, current_line_, message);
+        TextReaderException exception(current_line_index_, current_token_pos_,
+                                      std::string(current_line_, current_line_size_), message);
         throw exception;
     };
     
-    const char* const get_current_line() const { return current_line_.c_str(); };
+    const std::string get_current_line() const { return std::string(current_line_, current_line_size_); };
     
     inline bool is_space() {
         return is_symbol(' ') || is_symbol('\t');
@@ -286,10 +298,10 @@ public:
     inline bool is_eol() {
         load_first_line();
         // skip \r symbol at the end if exists
-        if (current_token_pos_ == current_line_.size() - 1 && current_line_[current_token_pos_] == '\r') {
+        if (current_token_pos_ == current_line_size_ - 1 && current_line_[current_token_pos_] == '\r') {
             current_token_pos_++;
         };
-        return current_token_pos_ >= current_line_.size();
+        return current_token_pos_ >= current_line_size_;
     };
     
     inline bool is_eof() { return is_eof_() && is_eol(); };
@@ -321,8 +333,8 @@ public:
     };
     
     inline const std::string read_until_eol() {
-        std::string result = get_current_token();
-        current_token_pos_ = current_line_.size();
+        std::string result(get_current_token(), current_line_size_ - current_token_pos_);
+        current_token_pos_ = current_line_size_;
         reset_token();
         return result;
     };
@@ -332,7 +344,7 @@ public:
         if (current_token_type_ != ttLiteral) {
             parse_error("Expect literal");
         };
-        std::string result = current_line_.substr(current_token_pos_, current_token_len_);
+        std::string result = std::string(current_line_ + current_token_pos_, current_token_len_);
         skip_token();
         return result;
     };
@@ -361,6 +373,16 @@ public:
     inline uint32_t read_uint32(const uint32_t min_value = 0, const uint32_t max_value = UINT32_MAX) {
         load_next_token();
         if (current_token_type_ == ttDec) {
+            // up to 9 digits cannot overflow, check the bounds once
+            if (current_token_len_ <= 9 && min_value == 0) {
+                const uint32_t result = bal::text_parse_dec9(current_line_ + current_token_pos_, current_token_len_);
+                if (result > max_value) {
+                    parse_error(std::string("The unsigned int 32 bit value is out of bounds: ") +
+                                std::to_string(min_value) + std::string("..") + std::to_string(max_value));
+                };
+                skip_token();
+                return result;
+            };
             uint64_t result = 0;
             auto index = 0;
             while (index < current_token_len_) {
@@ -383,7 +405,7 @@ public:
     std::string read_quoted() {
         load_next_token();
         if (current_token_type_ == ttQuoted) {
-            std::string result = current_line_.substr(current_token_pos_ + 1, current_token_len_ - 2);
+            std::string result = std::string(current_line_ + current_token_pos_ + 1, current_token_len_ - 2);
             skip_token();
             return result;
         } else {
@@ -396,16 +418,39 @@ public:
     inline void read_eof() { if (!is_eof_()) parse_error("Expect end of the file"); };
     
     inline void skip_space() {
-        while (current_token_pos_ < current_line_.size()) {
-            if (current_line_[current_token_pos_] != ' ')
-                break;
-            current_token_pos_++;
-            if (current_token_len_ > 0) {
-                reset_token();
+        if (current_token_pos_ < current_line_size_) {
+            const size_t spaces_size = bal::text_scan_spaces(current_line_ + current_token_pos_,
+                                                        current_line_size_ - current_token_pos_);
+            if (spaces_size > 0) {
+                current_token_pos_ += spaces_size;
+                if (current_token_len_ > 0) {
+                    reset_token();
+                };
             };
         };
     };
     
+    // fast path for a sequence of signed 32 bit decimal values separated with spaces
+    // and terminated with "0" value, see text_scan_sint32_sequence
+    // appends the values excluding the terminating one and returns true if it is read
+    // returns false if stopped in front of a value that should be read with the regular methods
+    template<typename VALUE_T>
+    inline bool read_sint32_sequence(std::vector<VALUE_T>& values) {
+        static_assert(sizeof(VALUE_T) == sizeof(int32_t), "VALUE_T must be a 32 bit integer");
+        load_first_line();
+        reset_token();
+        const size_t values_offset = values.size();
+        const size_t size = current_token_pos_ < current_line_size_ ? current_line_size_ - current_token_pos_ : 0;
+        values.resize(values_offset + (size + 1) / 2);
+        size_t values_size = 0;
+        bool is_terminated = false;
+        current_token_pos_ += bal::text_scan_sint32_sequence(current_line_ + current_token_pos_, size,
+                                                        (int32_t*)(values.data() + values_offset),
+                                                        values_size, is_terminated);
+        values.resize(values_offset + values_size);
+        return is_terminated;
+    };
+    
     inline void skip_symbol() {
         if (current_token_len_ > 0) {
             current_token_pos_++;
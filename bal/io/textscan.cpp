@@ -0,0 +1,241 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#include "textscan.hpp"
+#include "cpudispatch.hpp"
+
+#ifdef CPU_DISPATCH_X86
+#include <immintrin.h>
+#endif
+
+namespace bal {
+
+    // the text is processed in blocks of up to 64 symbols
+    // each block is classified into bit masks, bit i corresponds to symbol i
+    // bits beyond the block size are always 0
+    static const size_t constexpr BLOCK_SIZE = 64;
+
+    // number of symbols a token is guaranteed to have available within the current block
+    // longest token read by the scan is a minus, 9 digits and the following symbol
+    static const size_t constexpr BLOCK_TOKEN_SIZE_MAX = 16;
+
+    typedef void (*text_scan_classify_t)(const char* const data, const size_t size,
+                                         uint64_t& digits, uint64_t& spaces);
+
+    static inline size_t ctz64(const uint64_t value) {
+        return value == 0 ? 64 : __builtin_ctzll(value);
+    };
+
+    // mask bits starting from the given offset, shifted to the lowest bit
+    static inline uint64_t mask_from(const uint64_t mask, const size_t offset) {
+        return offset < BLOCK_SIZE ? mask >> offset : 0;
+    };
+
+    static inline uint64_t block_mask(const size_t size) {
+        return size >= BLOCK_SIZE ? UINT64_MAX : ((uint64_t)1 << size) - 1;
+    };
+
+    static void classify_scalar(const char* const data, const size_t size, uint64_t& digits, uint64_t& spaces) {
+        const size_t block_size = size < BLOCK_SIZE ? size : BLOCK_SIZE;
+        digits = 0;
+        spaces = 0;
+        for (size_t i = 0; i < block_size; i++) {
+            digits |= (uint64_t)(data[i] >= '0' && data[i] <= '9') << i;
+            spaces |= (uint64_t)(data[i] == ' ') << i;
+        };
+    };
+
+#ifdef CPU_DISPATCH_X86
+
+    // a vector load is safe if it does not cross the page boundary even if it reads
+    // beyond the end of the text; symbols beyond the end are masked out afterwards
+    // AddressSanitizer reports such loads from heap buffers, e.g. stream lines, as overflows,
+    // so the kernels are not instrumented; the text itself is checked where it is parsed
+    static const uintptr_t constexpr PAGE_SIZE_MIN = 4096;
+
+    static inline bool is_load_safe(const char* const data, const size_t size, const size_t load_size) {
+        return size >= load_size || ((uintptr_t)data & (PAGE_SIZE_MIN - 1)) <= PAGE_SIZE_MIN - load_size;
+    };
+
+    __attribute__((target("sse4.2"), no_sanitize_address))
+    static void classify_sse42(const char* const data, const size_t size, uint64_t& digits, uint64_t& spaces) {
+        const size_t block_size = size < BLOCK_SIZE ? size : BLOCK_SIZE;
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i digit_range = _mm_setr_epi8('0', '9', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+        digits = 0;
+        spaces = 0;
+        for (size_t i = 0; i < block_size; i += 16) {
+            if (!is_load_safe(data + i, size - i, 16)) {
+                uint64_t tail_digits, tail_spaces;
+                classify_scalar(data + i, block_size - i, tail_digits, tail_spaces);
+                digits |= tail_digits << i;
+                spaces |= tail_spaces << i;
+                break;
+            };
+            const __m128i value = _mm_loadu_si128((const __m128i*)(data + i));
+            const __m128i value_digits = _mm_cmpistrm(digit_range, value,
+                                                      _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_BIT_MASK);
+            digits |= (uint64_t)(uint16_t)_mm_cvtsi128_si32(value_digits) << i;
+            spaces |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(value, space)) << i;
+        };
+        digits &= block_mask(block_size);
+        spaces &= block_mask(block_size);
+    };
+
+    __attribute__((target("avx2"), no_sanitize_address))
+    static void classify_avx2(const char* const data, const size_t size, uint64_t& digits, uint64_t& spaces) {
+        const size_t block_size = size < BLOCK_SIZE ? size : BLOCK_SIZE;
+        const __m256i space = _mm256_set1_epi8(' ');
+        const __m256i digit_min = _mm256_set1_epi8('0' - 1);
+        const __m256i digit_max = _mm256_set1_epi8('9' + 1);
+        digits = 0;
+        spaces = 0;
+        for (size_t i = 0; i < block_size; i += 32) {
+            if (!is_load_safe(data + i, size - i, 32)) {
+                uint64_t tail_digits, tail_spaces;
+                classify_scalar(data + i, block_size - i, tail_digits, tail_spaces);
+                digits |= tail_digits << i;
+                spaces |= tail_spaces << i;
+                break;
+            };
+            const __m256i value = _mm256_loadu_si256((const __m256i*)(data + i));
+            // signed comparison excludes non ASCII symbols as well
+            const __m256i value_digits = _mm256_and_si256(_mm256_cmpgt_epi8(value, digit_min),
+                                                          _mm256_cmpgt_epi8(digit_max, value));
+            digits |= (uint64_t)(uint32_t)_mm256_movemask_epi8(value_digits) << i;
+            spaces |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(value, space)) << i;
+        };
+        digits &= block_mask(block_size);
+        spaces &= block_mask(block_size);
+    };
+
+#endif
+
+    static const CpuDispatch<TextScanIsa, tsiAuto, text_scan_classify_t>::implementation_t TEXT_SCAN_IMPLEMENTATIONS[] = {
+        {tsiScalar, cfNone, &classify_scalar},
+#ifdef CPU_DISPATCH_X86
+        {tsiSse42, cfSse42, &classify_sse42},
+        {tsiAvx2, cfAvx2, &classify_avx2},
+#endif
+    };
+
+    static CpuDispatch<TextScanIsa, tsiAuto, text_scan_classify_t> text_scan_dispatch(TEXT_SCAN_IMPLEMENTATIONS);
+
+    bool text_scan_is_supported(const TextScanIsa isa) {
+        return text_scan_dispatch.is_supported(isa);
+    };
+
+    bool text_scan_select(const TextScanIsa isa) {
+        return text_scan_dispatch.select(isa);
+    };
+
+    TextScanIsa text_scan_selected() {
+        return text_scan_dispatch.selected();
+    };
+
+    const char* text_scan_name(const TextScanIsa isa) {
+        switch (isa) {
+            case tsiAuto: return "auto";
+            case tsiScalar: return "scalar";
+            case tsiSse42: return "sse4.2";
+            case tsiAvx2: return "avx2";
+        };
+        return "unknown";
+    };
+
+    size_t text_scan_spaces(const char* const data, const size_t size) {
+        size_t pos = 0;
+        while (pos < size) {
+            uint64_t digits, spaces;
+            text_scan_dispatch.kernel()(data + pos, size - pos, digits, spaces);
+            const size_t count = ctz64(~spaces);
+            pos += count;
+            if (count < BLOCK_SIZE) {
+                break;
+            };
+        };
+        return pos < size ? pos : size;
+    };
+
+    size_t text_scan_digits(const char* const data, const size_t size) {
+        size_t pos = 0;
+        while (pos < size) {
+            uint64_t digits, spaces;
+            text_scan_dispatch.kernel()(data + pos, size - pos, digits, spaces);
+            const size_t count = ctz64(~digits);
+            pos += count;
+            if (count < BLOCK_SIZE) {
+                break;
+            };
+        };
+        return pos < size ? pos : size;
+    };
+
+    size_t text_scan_sint32_sequence(const char* const data, const size_t size,
+                                     int32_t* const values, size_t& values_size, bool& is_terminated) {
+        values_size = 0;
+        is_terminated = false;
+
+        uint64_t digits = 0;
+        uint64_t spaces = 0;
+        size_t block_pos = 0;
+        size_t block_size = 0;
+
+        // position following the last value read
+        // scan stops here if the next value cannot be read
+        size_t pos = 0;
+        size_t token_pos = 0;
+
+        while (true) {
+            // skip spaces, reload the block as needed
+            while (true) {
+                if (token_pos >= block_pos + block_size ||
+                    (token_pos + BLOCK_TOKEN_SIZE_MAX > block_pos + block_size && block_pos + block_size < size)) {
+                    if (token_pos >= size) {
+                        return pos;
+                    };
+                    block_pos = token_pos;
+                    block_size = size - block_pos < BLOCK_SIZE ? size - block_pos : BLOCK_SIZE;
+                    text_scan_dispatch.kernel()(data + block_pos, size - block_pos, digits, spaces);
+                };
+                const size_t count = ctz64(~mask_from(spaces, token_pos - block_pos));
+                token_pos += count;
+                if (token_pos < block_pos + block_size) {
+                    break;
+                };
+            };
+
+            // ensure the whole token is within the block
+            if (token_pos + BLOCK_TOKEN_SIZE_MAX > block_pos + block_size && block_pos + block_size < size) {
+                continue;
+            };
+
+            const bool is_negative = data[token_pos] == '-';
+            const size_t digits_pos = token_pos + (is_negative ? 1 : 0);
+            const size_t digits_size = ctz64(~mask_from(digits, digits_pos - block_pos));
+            const size_t token_end = digits_pos + digits_size;
+            const char next_symbol = token_end < size ? data[token_end] : ' ';
+
+            if (digits_size == 0 || digits_size > 9 || data[digits_pos] == '0') {
+                // a single 0 terminates the sequence unless followed by a letter or a digit
+                if (!is_negative && digits_size == 1 &&
+                    !(next_symbol == '_' || (next_symbol >= 'a' && next_symbol <= 'z') || (next_symbol >= 'A' && next_symbol <= 'Z'))) {
+                    is_terminated = true;
+                    return token_end;
+                };
+                return pos;
+            } else if (next_symbol != ' ') {
+                return pos;
+            };
+
+            const int32_t value = (int32_t)text_parse_dec9(data + digits_pos, digits_size);
+            values[values_size++] = is_negative ? -value : value;
+            pos = token_end;
+            token_pos = token_end;
+        };
+    };
+};
@@ -0,0 +1,64 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef textscan_hpp
+#define textscan_hpp
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace bal {
+
+    // scanning kernels for long runs of short decimal values separated with spaces
+    // the implementation is selected at runtime from those the CPU supports
+    // tsiAuto resets the selection to the best supported implementation
+    enum TextScanIsa {tsiAuto, tsiScalar, tsiSse42, tsiAvx2};
+
+    bool text_scan_is_supported(const TextScanIsa isa);
+    // intended for benchmarking; returns false if not supported, the selection is unchanged then
+    bool text_scan_select(const TextScanIsa isa);
+    TextScanIsa text_scan_selected();
+    const char* text_scan_name(const TextScanIsa isa);
+
+    // number of leading ' ' symbols
+    size_t text_scan_spaces(const char* const data, const size_t size);
+    // number of leading decimal digit symbols
+    size_t text_scan_digits(const char* const data, const size_t size);
+
+    // parses a sequence of signed decimal values separated with spaces up to the terminating "0" value
+    // values must have room for at least (size + 1) / 2 items
+    // stops in front of a value that needs a closer look, i.e. anything but 1 to 9 digits
+    // without leading zeros and with an optional minus; the value cannot overflow int32 then
+    // returns the number of symbols consumed, including the terminating 0 if reached
+    size_t text_scan_sint32_sequence(const char* const data, const size_t size,
+                                     int32_t* const values, size_t& values_size, bool& is_terminated);
+
+    // converts a run of 1 to 9 decimal digits, all validated already
+    inline uint32_t text_parse_dec9(const char* const data, const size_t size) {
+        uint64_t value = 0;
+        size_t index = 0;
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        if (size >= 8) {
+            // 8 digits at once, the first symbol in the lowest byte
+            memcpy(&value, data, 8);
+            value &= 0x0F0F0F0F0F0F0F0Full;
+            value = (value * 10 + (value >> 8)) & 0x00FF00FF00FF00FFull;
+            value = (value * 100 + (value >> 16)) & 0x0000FFFF0000FFFFull;
+            value = (value * 10000 + (value >> 32)) & 0x00000000FFFFFFFFull;
+            index = 8;
+        };
+#endif
+        while (index < size) {
+            value = value * 10 + (data[index] - '0');
+            index++;
+        };
+        return (uint32_t)value;
+    };
+};
+
+#endif /* textscan_hpp */
@@ -0,0 +1,149 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef textwriter_hpp
+#define textwriter_hpp
+
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <ostream>
+#include <string>
+#include "textformat.hpp"
+
+namespace bal {
+
+    // formats text into a large memory buffer and passes it to the stream once the buffer is full
+    // unlike std::ostream, nothing is flushed per line and no locale or flags are involved
+    // without a stream, the buffer grows to hold all text until it is taken with data() and clear()
+    class TextWriter {
+    public:
+        static const constexpr size_t BUFFER_SIZE = 1 << 20;
+
+    private:
+        std::ostream* stream_ = nullptr;
+        char* data_ = nullptr;
+        size_t size_ = 0;
+        size_t capacity_ = 0;
+        // number of symbols passed to the stream so far
+        size_t flushed_size_ = 0;
+
+        // the buffer is kept if it cannot grow
+        void resize(const size_t capacity) {
+            char* const data = (char*)realloc(data_, capacity);
+            if (data == nullptr) {
+                throw std::bad_alloc();
+            };
+            data_ = data;
+            capacity_ = capacity;
+        };
+
+        // makes room for at least size symbols
+        void overflow(const size_t size) {
+            if (stream_ != nullptr) {
+                flush();
+            };
+            if (capacity_ - size_ < size) {
+                size_t capacity = capacity_ > 0 ? capacity_ : BUFFER_SIZE;
+                while (capacity - size_ < size) {
+                    capacity *= 2;
+                };
+                resize(capacity);
+            };
+        };
+
+        inline char* reserve(const size_t size) {
+            if (capacity_ - size_ < size) {
+                overflow(size);
+            };
+            return data_ + size_;
+        };
+
+    public:
+        TextWriter(std::ostream& stream, const size_t buffer_size = BUFFER_SIZE): stream_(&stream) {
+            resize(buffer_size);
+        };
+        TextWriter() = default;
+        TextWriter(const TextWriter&) = delete;
+        TextWriter& operator = (const TextWriter&) = delete;
+
+        inline ~TextWriter() {
+            flush();
+            free(data_);
+        };
+
+        // passes the buffered text to the stream if any
+        void flush() {
+            if (stream_ != nullptr && size_ > 0) {
+                stream_->write(data_, size_);
+                flushed_size_ += size_;
+                size_ = 0;
+            };
+        };
+
+        inline void write(const char* const data, const size_t size) {
+            if (size > capacity_ && stream_ != nullptr) {
+                // large blocks go to the stream directly
+                flush();
+                stream_->write(data, size);
+                flushed_size_ += size;
+            } else {
+                memcpy(reserve(size), data, size);
+                size_ += size;
+            };
+        };
+
+        inline TextWriter& operator << (const char* const value) {
+            write(value, strlen(value));
+            return *this;
+        };
+
+        inline TextWriter& operator << (const std::string& value) {
+            write(value.data(), value.size());
+            return *this;
+        };
+
+        inline TextWriter& operator << (const char value) {
+            *reserve(1) = value;
+            size_++;
+            return *this;
+        };
+
+        inline TextWriter& operator << (const unsigned long long value) {
+            size_ += text_format_uint64(reserve(TEXT_FORMAT_UINT64_SIZE_MAX), value);
+            return *this;
+        };
+
+        inline TextWriter& operator << (const long long value) {
+            size_ += text_format_int64(reserve(TEXT_FORMAT_INT64_SIZE_MAX), value);
+            return *this;
+        };
+
+        inline TextWriter& operator << (const unsigned long value) { return *this << (unsigned long long)value; };
+        inline TextWriter& operator << (const unsigned value) { return *this << (unsigned long long)value; };
+        inline TextWriter& operator << (const unsigned short value) { return *this << (unsigned long long)value; };
+        inline TextWriter& operator << (const long value) { return *this << (long long)value; };
+        inline TextWriter& operator << (const int value) { return *this << (long long)value; };
+        inline TextWriter& operator << (const short value) { return *this << (long long)value; };
+
+        // same as std::ostream with the default precision
+        inline TextWriter& operator << (const double value) {
+            size_ += text_format_double(reserve(TEXT_FORMAT_DOUBLE_SIZE_MAX), value);
+            return *this;
+        };
+
+        // total number of symbols written, flushed or not
+        inline size_t size() const { return flushed_size_ + size_; };
+
+        // text buffered since the last flush or clear
+        inline const char* data() const { return data_; };
+        inline size_t buffered_size() const { return size_; };
+        inline void clear() { size_ = 0; };
+    };
+};
+
+#endif /* textwriter_hpp */
@@ -40,6 +40,7 @@ namespace bal {
     protected:
         void initialize();
         inline formula_named_variables_t& get_named_variables_() { return named_variables_; };
+        inline formula_parameters_t& get_parameters_() { return parameters_; };
     
     public:
         virtual const bool is_empty() const = 0;
@@ -0,0 +1,103 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef cpudispatch_hpp
+#define cpudispatch_hpp
+
+#include <stddef.h>
+
+// kernels for x86 extensions are compiled with target attributes and selected at runtime
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CPU_DISPATCH_X86
+#endif
+
+namespace bal {
+
+    // instruction set extensions that kernels are built for, cfNone for portable code
+    enum CpuFeature {cfNone, cfSse2, cfSsse3, cfSse42, cfAvx2};
+
+    inline bool cpu_supports(const CpuFeature feature) {
+#ifdef CPU_DISPATCH_X86
+        __builtin_cpu_init();
+        switch (feature) {
+            case cfNone: return true;
+            case cfSse2: return __builtin_cpu_supports("sse2");
+            case cfSsse3: return __builtin_cpu_supports("ssse3");
+            case cfSse42: return __builtin_cpu_supports("sse4.2");
+            case cfAvx2: return __builtin_cpu_supports("avx2");
+        };
+#endif
+        return feature == cfNone;
+    };
+
+    // selects one of several implementations of a kernel, e.g. a function pointer, at runtime
+    // implementations are identified by values of an enumeration ISA_T, AUTO stands for the best one
+    // they are listed from the portable one up, the last one the CPU supports is the best
+    // the best one is selected on construction, may be changed by select before any processing starts
+    template<typename ISA_T, ISA_T AUTO, typename KERNEL_T>
+    class CpuDispatch {
+    public:
+        typedef struct {
+            ISA_T isa;
+            CpuFeature feature;
+            KERNEL_T kernel;
+        } implementation_t;
+
+    private:
+        const implementation_t* const implementations_;
+        const size_t implementations_size_;
+        ISA_T selected_;
+        // copied from the implementation, so that a call through it takes a single load
+        KERNEL_T kernel_;
+
+        const implementation_t* find(const ISA_T isa) const {
+            for (size_t i = 0; i < implementations_size_; i++) {
+                if (implementations_[i].isa == isa) {
+                    return implementations_ + i;
+                };
+            };
+            return nullptr;
+        };
+
+        const implementation_t* best() const {
+            for (size_t i = implementations_size_; i > 1; i--) {
+                if (cpu_supports(implementations_[i - 1].feature)) {
+                    return implementations_ + i - 1;
+                };
+            };
+            return implementations_;
+        };
+
+    public:
+        template<size_t SIZE>
+        CpuDispatch(const implementation_t (&implementations)[SIZE]):
+            implementations_(implementations), implementations_size_(SIZE) {
+            select(AUTO);
+        };
+
+        bool is_supported(const ISA_T isa) const {
+            const implementation_t* const implementation = find(isa);
+            return isa == AUTO || (implementation != nullptr && cpu_supports(implementation->feature));
+        };
+
+        // returns false if not supported, the selection is unchanged then
+        bool select(const ISA_T isa) {
+            if (!is_supported(isa)) {
+                return false;
+            };
+            const implementation_t* const implementation = isa == AUTO ? best() : find(isa);
+            selected_ = implementation->isa;
+            kernel_ = implementation->kernel;
+            return true;
+        };
+
+        ISA_T selected() const { return selected_; };
+        KERNEL_T kernel() const { return kernel_; };
+    };
+};
+
+#endif /* cpudispatch_hpp */
@@ -9,25 +9,65 @@
 #define cnfutils_hpp
 
 #include <type_traits>
+#include <utility>
 #include <fstream>
+#include <memory>
 #include "streamable.hpp"
+#include "decompression.hpp"
+#include "mappedfile.hpp"
 
 namespace bal {
 
-    template<typename FORMULA_T, typename READER_T>
-    bool read_from_file(FORMULA_T& formula, const char* file_name) {
+    // reader_args are passed to the READER_T constructor following the stream arguments
+    // compressed files are detected by their magic bytes and decompressed on a separate thread
+    template<typename FORMULA_T, typename READER_T, typename... READER_ARGS_T>
+    bool read_from_file(FORMULA_T& formula, const char* file_name, READER_ARGS_T&&... reader_args) {
         static_assert(std::is_base_of<TextStreamReader<FORMULA_T>, READER_T>::value, "READER_T must be a descendant of TextStreamReader<FORMULA_T>");
         bool result = false;
-        std::ifstream file(file_name);
+        std::ifstream file(file_name, std::ios::in | std::ios::binary);
         if (file.is_open()) {
+            // regular files are memory mapped and parsed in place, anything else is read as a stream
+            MappedFile mapped_file;
+            std::unique_ptr<DecompressionStreamBuf> decompression;
             try {
-                READER_T reader(file);
-                reader.read(formula);
+                Compression compression = cmNone;
+                if (mapped_file.open(file_name)) {
+                    compression = compression_detect(mapped_file.data(), mapped_file.size());
+                    if (compression == cmNone) {
+                        READER_T reader(file, mapped_file.data(), mapped_file.size(), std::forward<READER_ARGS_T>(reader_args)...);
+                        reader.read(formula);
+                    } else if (compression_is_supported(compression)) {
+                        decompression.reset(new DecompressionStreamBuf(compression, mapped_file.data(), mapped_file.size()));
+                    };
+                } else {
+                    char prefix[COMPRESSION_MAGIC_SIZE_MAX];
+                    const size_t prefix_size = (size_t)file.rdbuf()->sgetn(prefix, sizeof(prefix));
+                    compression = compression_detect(prefix, prefix_size);
+                    if (compression_is_supported(compression)) {
+                        decompression.reset(new DecompressionStreamBuf(compression, file, prefix, prefix_size));
+                    };
+                };
+                if (decompression) {
+                    std::istream stream(decompression.get());
+                    READER_T reader(stream, std::forward<READER_ARGS_T>(reader_args)...);
+                    reader.read(formula);
+                };
+                if (!compression_is_supported(compression)) {
+                    std::cout << "Error: " << compression_name(compression) << " compressed files are not supported by this build." << std::endl;
+                } else if (decompression && !decompression->error().empty()) {
+                    std::cout << "Error: cannot decompress the file \"" << file_name << "\": " << decompression->error() << "." << std::endl;
+                } else {
+                    result = true;
+                };
                 file.close();
-                result = true;
             }
             catch (TextReaderException e) {
-                std::cout << "Parse Error: " << e << "." << std::endl;
+                // broken compressed content is likely to cause a parse error first
+                if (decompression && !decompression->error().empty()) {
+                    std::cout << "Error: cannot decompress the file \"" << file_name << "\": " << decompression->error() << "." << std::endl;
+                } else {
+                    std::cout << "Parse Error: " << e << "." << std::endl;
+                };
             }
         }
         else {
@@ -36,13 +76,15 @@ namespace bal {
         return result;
     };
 
-    template<typename FORMULA_T, typename WRITER_T>
-    bool write_to_file(const FORMULA_T& formula, const char* file_name) {
+    // writer_args are passed to the WRITER_T constructor following the stream
+    template<typename FORMULA_T, typename WRITER_T, typename... WRITER_ARGS_T>
+    bool write_to_file(const FORMULA_T& formula, const char* file_name, WRITER_ARGS_T&&... writer_args) {
         static_assert(std::is_base_of<StreamWriter<FORMULA_T>, WRITER_T>::value, "WRITER_T must be a descendant of StreamWriter<FORMULA_T>");
         bool result = false;
-        std::ofstream file(file_name);
+        // binary, so that binary formats are written as is and text lines end with "\n" everywhere
+        std::ofstream file(file_name, std::ios::out | std::ios::binary);
         if (file.is_open()) {
-            WRITER_T writer(file);
+            WRITER_T writer(file, std::forward<WRITER_ARGS_T>(writer_args)...);
             writer.write(formula);
             file.close();
             result = true;
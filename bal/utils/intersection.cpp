@@ -0,0 +1,128 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#include "intersection.hpp"
+#include "cpudispatch.hpp"
+
+#ifdef CPU_DISPATCH_X86
+#include <immintrin.h>
+#endif
+
+namespace bal {
+
+    typedef size_t (*intersection_size_t)(const uint32_t* const a, const size_t a_size, const uint32_t* const b, const size_t b_size);
+
+    // merges the arrays from the given positions
+    static inline size_t intersection_merge(const uint32_t* const a, const size_t a_size, size_t i,
+                                            const uint32_t* const b, const size_t b_size, size_t j) {
+        size_t result = 0;
+        while (i < a_size && j < b_size) {
+            if (a[i] < b[j]) {
+                i++;
+            } else if (b[j] < a[i]) {
+                j++;
+            } else {
+                result++;
+                i++;
+                j++;
+            };
+        };
+        return result;
+    };
+
+    static size_t intersection_size_scalar(const uint32_t* const a, const size_t a_size, const uint32_t* const b, const size_t b_size) {
+        return intersection_merge(a, a_size, 0, b, b_size, 0);
+    };
+
+#ifdef CPU_DISPATCH_X86
+
+    // bits set in a 4 bit mask; popcnt is not part of the targets and the builtin would be a call
+    static const uint8_t MASK_BITS_SIZE[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+    // values are unsigned but equality does not depend on the sign
+    __attribute__((target("sse2")))
+    static size_t intersection_size_sse2(const uint32_t* const a, const size_t a_size, const uint32_t* const b, const size_t b_size) {
+        size_t result = 0;
+        size_t i = 0;
+        size_t j = 0;
+        while (i + 4 <= a_size && j + 4 <= b_size) {
+            const __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+            const __m128i vb = _mm_loadu_si128((const __m128i*)(b + j));
+            const __m128i matches = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi32(va, vb), _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x39))),
+                _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x4E)), _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x93))));
+            result += MASK_BITS_SIZE[_mm_movemask_ps(_mm_castsi128_ps(matches))];
+            const uint32_t a_last = a[i + 3];
+            const uint32_t b_last = b[j + 3];
+            i += a_last <= b_last ? 4 : 0;
+            j += b_last <= a_last ? 4 : 0;
+        };
+        return result + intersection_merge(a, a_size, i, b, b_size, j);
+    };
+
+    __attribute__((target("avx2")))
+    static size_t intersection_size_avx2(const uint32_t* const a, const size_t a_size, const uint32_t* const b, const size_t b_size) {
+        size_t result = 0;
+        size_t i = 0;
+        size_t j = 0;
+        const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+        while (i + 8 <= a_size && j + 8 <= b_size) {
+            const __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+            __m256i vb = _mm256_loadu_si256((const __m256i*)(b + j));
+            __m256i matches = _mm256_cmpeq_epi32(va, vb);
+            for (unsigned k = 1; k < 8; k++) {
+                vb = _mm256_permutevar8x32_epi32(vb, rotate);
+                matches = _mm256_or_si256(matches, _mm256_cmpeq_epi32(va, vb));
+            };
+            const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(matches));
+            result += MASK_BITS_SIZE[mask & 0xF] + MASK_BITS_SIZE[mask >> 4];
+            const uint32_t a_last = a[i + 7];
+            const uint32_t b_last = b[j + 7];
+            i += a_last <= b_last ? 8 : 0;
+            j += b_last <= a_last ? 8 : 0;
+        };
+        return result + intersection_merge(a, a_size, i, b, b_size, j);
+    };
+
+#endif
+
+    static const CpuDispatch<IntersectionIsa, iiAuto, intersection_size_t>::implementation_t INTERSECTION_IMPLEMENTATIONS[] = {
+        {iiScalar, cfNone, &intersection_size_scalar},
+#ifdef CPU_DISPATCH_X86
+        {iiSse2, cfSse2, &intersection_size_sse2},
+        {iiAvx2, cfAvx2, &intersection_size_avx2},
+#endif
+    };
+
+    static CpuDispatch<IntersectionIsa, iiAuto, intersection_size_t> intersection_dispatch(INTERSECTION_IMPLEMENTATIONS);
+
+    bool intersection_is_supported(const IntersectionIsa isa) {
+        return intersection_dispatch.is_supported(isa);
+    };
+
+    bool intersection_select(const IntersectionIsa isa) {
+        return intersection_dispatch.select(isa);
+    };
+
+    IntersectionIsa intersection_selected() {
+        return intersection_dispatch.selected();
+    };
+
+    const char* intersection_name(const IntersectionIsa isa) {
+        switch (isa) {
+            case iiAuto: return "auto";
+            case iiScalar: return "scalar";
+            case iiSse2: return "sse2";
+            case iiAvx2: return "avx2";
+        };
+        return "unknown";
+    };
+
+    size_t intersection_size(const uint32_t* const a, const size_t a_size, const uint32_t* const b, const size_t b_size) {
+        return intersection_dispatch.kernel()(a, a_size, b, b_size);
+    };
+};
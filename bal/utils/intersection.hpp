@@ -0,0 +1,32 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef intersection_hpp
+#define intersection_hpp
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace bal {
+
+    // size of the intersection of two sorted arrays of distinct values, e.g. rows of a graph
+    // the implementation is selected at runtime from those the CPU supports
+    // the vector kernels compare blocks of 4 or 8 values with each other, all rotations of one
+    // against the other, and skip the block with the lower last value
+    // iiAuto resets the selection to the best supported implementation
+    enum IntersectionIsa {iiAuto, iiScalar, iiSse2, iiAvx2};
+
+    bool intersection_is_supported(const IntersectionIsa isa);
+    // intended for benchmarking; returns false if not supported, the selection is unchanged then
+    bool intersection_select(const IntersectionIsa isa);
+    IntersectionIsa intersection_selected();
+    const char* intersection_name(const IntersectionIsa isa);
+
+    size_t intersection_size(const uint32_t* const a, const size_t a_size, const uint32_t* const b, const size_t b_size);
+};
+
+#endif /* intersection_hpp */
@@ -0,0 +1,89 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef parallel_hpp
+#define parallel_hpp
+
+#include <stdint.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace bal {
+
+    // more threads than this many per hardware thread only add overhead, and the system may fail to create them
+    static const constexpr unsigned PARALLEL_THREADS_PER_HARDWARE_THREAD_MAX = 4;
+
+    // the number of threads to use for the threads_size given to the classes of the library:
+    // the maximal number of threads, 0 for as many as the hardware supports
+    // larger numbers are limited to PARALLEL_THREADS_PER_HARDWARE_THREAD_MAX per hardware thread
+    inline unsigned parallel_threads_size(const unsigned threads_size) {
+        const unsigned hardware_threads_size = std::max(std::thread::hardware_concurrency(), 1u);
+        if (threads_size == 0) {
+            return hardware_threads_size;
+        };
+        return std::min(threads_size, hardware_threads_size * PARALLEL_THREADS_PER_HARDWARE_THREAD_MAX);
+    };
+
+    // executes task(index) for each index in 0..tasks_size-1 on its own thread
+    // the first task is executed on the calling thread; returns when all tasks are done
+    // tasks are expected to handle their own exceptions
+    template<typename TASK_T>
+    inline void parallel_execute(const unsigned tasks_size, TASK_T task) {
+        std::vector<std::thread> threads;
+        threads.reserve(tasks_size > 0 ? tasks_size - 1 : 0);
+        for (unsigned i = 1; i < tasks_size; i++) {
+            threads.emplace_back(task, i);
+        };
+        if (tasks_size > 0) {
+            task(0);
+        };
+        for (auto& thread: threads) {
+            thread.join();
+        };
+    };
+
+    // splits [0, size) into tasks_size consecutive ranges of nearly equal size
+    // and executes task(index, begin, end) for each of them in parallel
+    template<typename SIZE_T, typename TASK_T>
+    inline void parallel_for(const unsigned tasks_size, const SIZE_T size, TASK_T task) {
+        parallel_execute(tasks_size, [&](const unsigned index) {
+            const SIZE_T begin = (SIZE_T)((uint64_t)size * index / tasks_size);
+            const SIZE_T end = (SIZE_T)((uint64_t)size * (index + 1) / tasks_size);
+            task(index, begin, end);
+        });
+    };
+
+    // replaces values[i] with the sum of values[0..i-1], returns the total
+    // each task sums its own range first, then offsets it by the sum of the preceding ranges
+    template<typename VALUE_T, typename SIZE_T>
+    inline VALUE_T parallel_exclusive_scan(const unsigned tasks_size, VALUE_T* const values, const SIZE_T size) {
+        std::vector<VALUE_T> range_sums(tasks_size + 1, 0);
+        parallel_for(tasks_size, size, [&](const unsigned index, const SIZE_T begin, const SIZE_T end) {
+            VALUE_T sum = 0;
+            for (SIZE_T i = begin; i < end; i++) {
+                const VALUE_T value = values[i];
+                values[i] = sum;
+                sum += value;
+            };
+            range_sums[index + 1] = sum;
+        });
+        for (unsigned i = 1; i <= tasks_size; i++) {
+            range_sums[i] += range_sums[i - 1];
+        };
+        parallel_for(tasks_size, size, [&](const unsigned index, const SIZE_T begin, const SIZE_T end) {
+            if (index > 0) {
+                for (SIZE_T i = begin; i < end; i++) {
+                    values[i] += range_sums[index];
+                };
+            };
+        });
+        return range_sums[tasks_size];
+    };
+};
+
+#endif /* parallel_hpp */
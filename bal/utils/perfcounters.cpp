@@ -0,0 +1,121 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#include "perfcounters.hpp"
+#include <string.h>
+#include <errno.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bal {
+
+    namespace {
+        int perf_counters_fds[PC_SIZE] = {-1, -1, -1, -1, -1, -1, -1, -1};
+        bool perf_counters_is_open_ = false;
+
+#ifdef __linux__
+        // type and config by counter
+        const uint32_t perf_counters_events[PC_SIZE][2] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES}, {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES}, {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS}, {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}, {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES}
+        };
+
+        int perf_event_open(perf_event_attr& attr) {
+            return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        };
+#endif
+    };
+
+    bool perf_counters_open(std::string& error) {
+        perf_counters_close();
+#ifdef __linux__
+        int last_errno = 0;
+        for (unsigned i = 0; i < PC_SIZE; i++) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = perf_counters_events[i][0];
+            attr.config = perf_counters_events[i][1];
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.inherit = 1;
+            // software events such as context switches occur in the kernel
+            attr.exclude_kernel = attr.type == PERF_TYPE_HARDWARE ? 1 : 0;
+            attr.exclude_hv = 1;
+            perf_counters_fds[i] = perf_event_open(attr);
+            if (perf_counters_fds[i] < 0 && attr.exclude_kernel == 0) {
+                attr.exclude_kernel = 1;
+                perf_counters_fds[i] = perf_event_open(attr);
+            };
+            if (perf_counters_fds[i] < 0) {
+                last_errno = errno;
+            } else {
+                perf_counters_is_open_ = true;
+            };
+        };
+        if (!perf_counters_is_open_) {
+            error = strerror(last_errno);
+        };
+#else
+        error = "not supported on this platform";
+#endif
+        return perf_counters_is_open_;
+    };
+
+    void perf_counters_close() {
+        for (unsigned i = 0; i < PC_SIZE; i++) {
+#ifdef __linux__
+            if (perf_counters_fds[i] >= 0) {
+                close(perf_counters_fds[i]);
+            };
+#endif
+            perf_counters_fds[i] = -1;
+        };
+        perf_counters_is_open_ = false;
+    };
+
+    bool perf_counters_is_open() {
+        return perf_counters_is_open_;
+    };
+
+    bool perf_counters_is_available(const PerfCounter counter) {
+        return perf_counters_fds[counter] >= 0;
+    };
+
+    void perf_counters_read(perf_counters_t& counters) {
+        for (unsigned i = 0; i < PC_SIZE; i++) {
+            counters.values[i] = 0;
+#ifdef __linux__
+            // value, time enabled, time running
+            uint64_t data[3];
+            if (perf_counters_fds[i] >= 0 && read(perf_counters_fds[i], data, sizeof(data)) == sizeof(data)) {
+                counters.values[i] = data[2] > 0 && data[2] < data[1] ? (uint64_t)((double)data[0] * data[1] / data[2]) : data[0];
+            };
+#endif
+        };
+    };
+
+    const char* perf_counter_name(const PerfCounter counter) {
+        switch (counter) {
+            case pcCycles: return "cycles";
+            case pcInstructions: return "instructions";
+            case pcCacheReferences: return "cache_references";
+            case pcCacheMisses: return "cache_misses";
+            case pcBranches: return "branches";
+            case pcBranchMisses: return "branch_misses";
+            case pcPageFaults: return "page_faults";
+            case pcContextSwitches: return "context_switches";
+            case PC_SIZE: break;
+        };
+        return "unknown";
+    };
+};
@@ -0,0 +1,42 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef perfcounters_hpp
+#define perfcounters_hpp
+
+#include <stdint.h>
+#include <string>
+
+namespace bal {
+
+    // hardware event counters of the process, Linux perf_event_open
+    // hardware events are counted in user space only, as permitted with perf_event_paranoid of 2;
+    // threads created after the counters are opened are counted too, once they have finished
+    // counters that cannot be opened are left out; virtual machines and containers often lack
+    // the hardware ones while the software ones, page faults and context switches, remain
+    enum PerfCounter {
+        pcCycles, pcInstructions, pcCacheReferences, pcCacheMisses, pcBranches, pcBranchMisses,
+        pcPageFaults, pcContextSwitches,
+        PC_SIZE
+    };
+
+    typedef struct {
+        uint64_t values[PC_SIZE];
+    } perf_counters_t;
+
+    // opens the counters available, to be called before any threads are created
+    // false with the reason if none is
+    bool perf_counters_open(std::string& error);
+    void perf_counters_close();
+    bool perf_counters_is_open();
+    bool perf_counters_is_available(const PerfCounter counter);
+    // current values, scaled up if the kernel multiplexed the counters; 0 for those not available
+    void perf_counters_read(perf_counters_t& counters);
+    const char* perf_counter_name(const PerfCounter counter);
+};
+
+#endif /* perfcounters_hpp */
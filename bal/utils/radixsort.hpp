@@ -0,0 +1,94 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef radixsort_hpp
+#define radixsort_hpp
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "parallel.hpp"
+
+namespace bal {
+
+    // number of bits needed to represent values from 0 to value inclusive
+    inline unsigned radix_sort_bits(uint64_t value) {
+        unsigned result = 0;
+        while (value > 0) {
+            value >>= 1;
+            result++;
+        };
+        return result;
+    };
+
+    // stable LSD radix sort of items by the lowest key_bits bits of key(item), 8 bits per pass
+    // each pass counts digits for a range of items per task, then the tasks scatter their ranges
+    // to the positions following the same digit of the preceding ranges; this keeps the sort stable
+    // T is copied with memcpy semantics; passes where all items share the same digit are skipped
+    template<typename T, typename KEY_F>
+    void parallel_radix_sort(const unsigned threads_size, T* const data, const size_t size,
+                             const unsigned key_bits, KEY_F key) {
+        static const constexpr unsigned DIGIT_BITS = 8;
+        static const constexpr size_t DIGITS_SIZE = 1 << DIGIT_BITS;
+        // not worth starting threads for fewer items
+        static const constexpr size_t TASK_SIZE_MIN = 1 << 14;
+
+        if (size < 2 || key_bits == 0) {
+            return;
+        };
+
+        const unsigned tasks_size = size / parallel_threads_size(threads_size) >= TASK_SIZE_MIN ?
+            parallel_threads_size(threads_size) : 1;
+        std::vector<T> buffer(size);
+        T* source = data;
+        T* target = buffer.data();
+        std::vector<size_t> positions(tasks_size * DIGITS_SIZE);
+
+        for (unsigned shift = 0; shift < key_bits; shift += DIGIT_BITS) {
+            parallel_for(tasks_size, size, [&](const unsigned index, const size_t begin, const size_t end) {
+                size_t* const counts = positions.data() + index * DIGITS_SIZE;
+                memset(counts, 0, DIGITS_SIZE * sizeof(size_t));
+                for (size_t i = begin; i < end; i++) {
+                    counts[(key(source[i]) >> shift) & (DIGITS_SIZE - 1)]++;
+                };
+            });
+
+            // positions are ordered by digit, then by task
+            size_t position = 0;
+            bool is_sorted = false;
+            for (size_t digit = 0; digit < DIGITS_SIZE; digit++) {
+                size_t digit_size = 0;
+                for (unsigned index = 0; index < tasks_size; index++) {
+                    const size_t count = positions[index * DIGITS_SIZE + digit];
+                    positions[index * DIGITS_SIZE + digit] = position;
+                    position += count;
+                    digit_size += count;
+                };
+                is_sorted = is_sorted || digit_size == size;
+            };
+            if (is_sorted) {
+                continue;
+            };
+
+            parallel_for(tasks_size, size, [&](const unsigned index, const size_t begin, const size_t end) {
+                size_t* const task_positions = positions.data() + index * DIGITS_SIZE;
+                for (size_t i = begin; i < end; i++) {
+                    target[task_positions[(key(source[i]) >> shift) & (DIGITS_SIZE - 1)]++] = source[i];
+                };
+            });
+            std::swap(source, target);
+        };
+
+        if (source != data) {
+            parallel_for(tasks_size, size, [&](const unsigned, const size_t begin, const size_t end) {
+                memcpy(data + begin, source + begin, (end - begin) * sizeof(T));
+            });
+        };
+    };
+};
+
+#endif /* radixsort_hpp */
@@ -0,0 +1,135 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef sortingnetwork_hpp
+#define sortingnetwork_hpp
+
+#include <stddef.h>
+#include <algorithm>
+
+namespace bal {
+
+    // puts the smaller value first; min/max compile to conditional moves, no branches
+    template<typename T>
+    inline void sorting_network_exchange(T* const values, const size_t i, const size_t j) {
+        const T a = values[i];
+        const T b = values[j];
+        values[i] = std::min(a, b);
+        values[j] = std::max(a, b);
+    };
+
+    // sorts SIZE values with a fixed sequence of compare-exchanges
+    // the networks are the smallest known for each size, see Knuth TAOCP vol. 3, 5.3.4
+    template<size_t SIZE>
+    struct SortingNetwork;
+
+    template<>
+    struct SortingNetwork<2> {
+        template<typename T>
+        static inline void sort(T* const v) {
+            sorting_network_exchange(v, 0, 1);
+        };
+    };
+
+    template<>
+    struct SortingNetwork<3> {
+        template<typename T>
+        static inline void sort(T* const v) {
+            sorting_network_exchange(v, 0, 2);
+            sorting_network_exchange(v, 0, 1);
+            sorting_network_exchange(v, 1, 2);
+        };
+    };
+
+    template<>
+    struct SortingNetwork<4> {
+        template<typename T>
+        static inline void sort(T* const v) {
+            sorting_network_exchange(v, 0, 1); sorting_network_exchange(v, 2, 3);
+            sorting_network_exchange(v, 0, 2); sorting_network_exchange(v, 1, 3);
+            sorting_network_exchange(v, 1, 2);
+        };
+    };
+
+    template<>
+    struct SortingNetwork<5> {
+        template<typename T>
+        static inline void sort(T* const v) {
+            sorting_network_exchange(v, 0, 3); sorting_network_exchange(v, 1, 4);
+            sorting_network_exchange(v, 0, 2); sorting_network_exchange(v, 1, 3);
+            sorting_network_exchange(v, 0, 1); sorting_network_exchange(v, 2, 4);
+            sorting_network_exchange(v, 1, 2); sorting_network_exchange(v, 3, 4);
+            sorting_network_exchange(v, 2, 3);
+        };
+    };
+
+    template<>
+    struct SortingNetwork<6> {
+        template<typename T>
+        static inline void sort(T* const v) {
+            sorting_network_exchange(v, 0, 5); sorting_network_exchange(v, 1, 3); sorting_network_exchange(v, 2, 4);
+            sorting_network_exchange(v, 1, 2); sorting_network_exchange(v, 3, 4);
+            sorting_network_exchange(v, 0, 3); sorting_network_exchange(v, 2, 5);
+            sorting_network_exchange(v, 0, 1); sorting_network_exchange(v, 2, 3); sorting_network_exchange(v, 4, 5);
+            sorting_network_exchange(v, 1, 2); sorting_network_exchange(v, 3, 4);
+        };
+    };
+
+    template<>
+    struct SortingNetwork<7> {
+        template<typename T>
+        static inline void sort(T* const v) {
+            sorting_network_exchange(v, 0, 6); sorting_network_exchange(v, 2, 3); sorting_network_exchange(v, 4, 5);
+            sorting_network_exchange(v, 0, 2); sorting_network_exchange(v, 1, 4); sorting_network_exchange(v, 3, 6);
+            sorting_network_exchange(v, 0, 1); sorting_network_exchange(v, 2, 5); sorting_network_exchange(v, 3, 4);
+            sorting_network_exchange(v, 1, 2); sorting_network_exchange(v, 4, 6);
+            sorting_network_exchange(v, 2, 3); sorting_network_exchange(v, 4, 5);
+            sorting_network_exchange(v, 1, 2); sorting_network_exchange(v, 3, 4); sorting_network_exchange(v, 5, 6);
+        };
+    };
+
+    template<>
+    struct SortingNetwork<8> {
+        template<typename T>
+        static inline void sort(T* const v) {
+            sorting_network_exchange(v, 0, 2); sorting_network_exchange(v, 1, 3);
+            sorting_network_exchange(v, 4, 6); sorting_network_exchange(v, 5, 7);
+            sorting_network_exchange(v, 0, 4); sorting_network_exchange(v, 1, 5);
+            sorting_network_exchange(v, 2, 6); sorting_network_exchange(v, 3, 7);
+            sorting_network_exchange(v, 0, 1); sorting_network_exchange(v, 2, 3);
+            sorting_network_exchange(v, 4, 5); sorting_network_exchange(v, 6, 7);
+            sorting_network_exchange(v, 2, 4); sorting_network_exchange(v, 3, 5);
+            sorting_network_exchange(v, 1, 4); sorting_network_exchange(v, 3, 6);
+            sorting_network_exchange(v, 1, 2); sorting_network_exchange(v, 3, 4); sorting_network_exchange(v, 5, 6);
+        };
+    };
+
+    // largest size sorted with a network, longer sequences go to std::sort
+    static const constexpr size_t SORTING_NETWORK_SIZE_MAX = 8;
+
+    // sorts short sequences with a sorting network, the rest with std::sort
+    template<typename T>
+    inline void sort_short(T* const values, const size_t size) {
+        switch (size) {
+            case 0:
+            case 1:
+                break;
+            case 2: SortingNetwork<2>::sort(values); break;
+            case 3: SortingNetwork<3>::sort(values); break;
+            case 4: SortingNetwork<4>::sort(values); break;
+            case 5: SortingNetwork<5>::sort(values); break;
+            case 6: SortingNetwork<6>::sort(values); break;
+            case 7: SortingNetwork<7>::sort(values); break;
+            case 8: SortingNetwork<8>::sort(values); break;
+            default:
+                std::sort(values, values + size);
+                break;
+        };
+    };
+};
+
+#endif /* sortingnetwork_hpp */
@@ -0,0 +1,177 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#include "statistics.hpp"
+#include <iomanip>
+#include <locale>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace bal {
+
+    thread_local statistics_shard_t* __statistics_shard_ = nullptr;
+
+    namespace {
+
+        struct statistics_registry_t {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<statistics_shard_t>> shards;
+            // shards of the threads that have finished
+            std::vector<statistics_shard_t*> released_shards;
+        };
+
+        // constructed on the first use, so shards can be acquired during static initialization
+        statistics_registry_t& statistics_registry() {
+            static statistics_registry_t registry;
+            return registry;
+        };
+
+        void statistics_shard_clear(statistics_shard_t& shard) {
+            for (auto& value: shard.counters) {
+                value.store(0, std::memory_order_relaxed);
+            };
+            for (unsigned i = 0; i < ST_SIZE; i++) {
+                shard.timers_ns[i].store(0, std::memory_order_relaxed);
+                shard.timers_count[i].store(0, std::memory_order_relaxed);
+                for (auto& value: shard.timers_perf[i]) {
+                    value.store(0, std::memory_order_relaxed);
+                };
+            };
+        };
+
+        // hands the shard over to the registry when the thread finishes
+        struct statistics_shard_owner_t {
+            ~statistics_shard_owner_t() {
+                if (__statistics_shard_ != nullptr) {
+                    statistics_registry_t& registry = statistics_registry();
+                    std::lock_guard<std::mutex> lock(registry.mutex);
+                    registry.released_shards.push_back(__statistics_shard_);
+                    __statistics_shard_ = nullptr;
+                };
+            };
+        };
+
+        thread_local statistics_shard_owner_t statistics_shard_owner;
+    };
+
+    statistics_shard_t& __statistics_shard_acquire() {
+        statistics_registry_t& registry = statistics_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (!registry.released_shards.empty()) {
+            __statistics_shard_ = registry.released_shards.back();
+            registry.released_shards.pop_back();
+        } else {
+            registry.shards.emplace_back(new statistics_shard_t);
+            __statistics_shard_ = registry.shards.back().get();
+            statistics_shard_clear(*__statistics_shard_);
+        };
+        // the owner is constructed on its first use, it releases the shard on thread exit
+        (void)&statistics_shard_owner;
+        return *__statistics_shard_;
+    };
+
+    statistics_t statistics_get() {
+        statistics_t result = {};
+        statistics_registry_t& registry = statistics_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto& shard: registry.shards) {
+            for (unsigned i = 0; i < SC_SIZE; i++) {
+                result.counters[i] += shard->counters[i].load(std::memory_order_relaxed);
+            };
+            for (unsigned i = 0; i < ST_SIZE; i++) {
+                result.timers_ns[i] += shard->timers_ns[i].load(std::memory_order_relaxed);
+                result.timers_count[i] += shard->timers_count[i].load(std::memory_order_relaxed);
+                for (unsigned j = 0; j < PC_SIZE; j++) {
+                    result.timers_perf[i][j] += shard->timers_perf[i][j].load(std::memory_order_relaxed);
+                };
+            };
+        };
+        result.shards_size = (unsigned)registry.shards.size();
+        return result;
+    };
+
+    void statistics_reset() {
+        statistics_registry_t& registry = statistics_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto& shard: registry.shards) {
+            statistics_shard_clear(*shard);
+        };
+    };
+
+    const char* statistics_counter_name(const StatisticsCounter counter) {
+        switch (counter) {
+            case scAppendClause: return "append_clause";
+            case scFindClauseFound: return "find_clause_found";
+            case scFindClauseUnfound: return "find_clause_unfound";
+            case scCompareClauses: return "compare_clauses";
+            case scNormalizeClause: return "normalize_clause";
+            case scStageClause: return "stage_clause";
+            case SC_SIZE: break;
+        };
+        return "unknown";
+    };
+
+    const char* statistics_timer_name(const StatisticsTimer timer) {
+        switch (timer) {
+            case stRead: return "read";
+            case stParse: return "parse";
+            case stIndex: return "index";
+            case stCompress: return "compress";
+            case stWrite: return "write";
+            case stVariables: return "variables";
+            case stEdges: return "edges";
+            case stCommunities: return "communities";
+            case stPartition: return "partition";
+            case stGraphStatistics: return "graph_statistics";
+            case ST_SIZE: break;
+        };
+        return "unknown";
+    };
+
+    // {"counters_enabled": ..., "perf_counters_enabled": ..., "shards": ..., "counters": {"<name>": <count>, ...},
+    //  "timers": {"<name>": {"count": ..., "ms": ..., "cycles": ..., ...}, ...}}
+    // counters is empty unless compiled with BAL_STATISTICS, timers lists those that ran
+    // with the hardware events available if the performance counters are open
+    void statistics_write_json(std::ostream& output, const statistics_t& statistics) {
+        // numbers are written in full precision and the classic locale whatever the output is imbued with
+        std::ostringstream stream;
+        stream.imbue(std::locale::classic());
+        stream << std::setprecision(17);
+        stream << "{\n";
+        stream << "  \"counters_enabled\": " << (STATISTICS_COUNTERS_ENABLED ? "true" : "false") << ",\n";
+        stream << "  \"perf_counters_enabled\": " << (perf_counters_is_open() ? "true" : "false") << ",\n";
+        stream << "  \"shards\": " << statistics.shards_size << ",\n";
+        stream << "  \"counters\": {";
+        if (STATISTICS_COUNTERS_ENABLED) {
+            for (unsigned i = 0; i < SC_SIZE; i++) {
+                stream << (i > 0 ? ",\n" : "\n") << "    \"" << statistics_counter_name((StatisticsCounter)i) << "\": " << statistics.counters[i];
+            };
+            stream << "\n  ";
+        };
+        stream << "},\n";
+        stream << "  \"timers\": {";
+        bool is_first = true;
+        for (unsigned i = 0; i < ST_SIZE; i++) {
+            if (statistics.timers_count[i] > 0) {
+                stream << (is_first ? "\n" : ",\n") << "    \"" << statistics_timer_name((StatisticsTimer)i) << "\": {\"count\": ";
+                stream << statistics.timers_count[i] << ", \"ms\": " << statistics.timers_ns[i] / 1000000.0;
+                for (unsigned j = 0; j < PC_SIZE; j++) {
+                    if (perf_counters_is_available((PerfCounter)j)) {
+                        stream << ", \"" << perf_counter_name((PerfCounter)j) << "\": " << statistics.timers_perf[i][j];
+                    };
+                };
+                stream << "}";
+                is_first = false;
+            };
+        };
+        stream << (is_first ? "}\n" : "\n  }\n");
+        stream << "}\n";
+        output << stream.str();
+    };
+};
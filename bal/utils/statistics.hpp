@@ -0,0 +1,81 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef statistics_hpp
+#define statistics_hpp
+
+#include <stdint.h>
+#include <atomic>
+#include <ostream>
+#include "perfcounters.hpp"
+
+namespace bal {
+
+    // event counters for the hot loops, compiled in with BAL_STATISTICS only, and timers for
+    // the phases of the processing, always available, see TraceSpan
+    // each thread updates its own shard without synchronization, the shards are summed up on demand;
+    // a shard outlives its thread so nothing is lost, it is reused by the next new thread
+    enum StatisticsCounter {
+        scAppendClause, scFindClauseFound, scFindClauseUnfound, scCompareClauses, scNormalizeClause, scStageClause,
+        SC_SIZE
+    };
+
+    enum StatisticsTimer {
+        stRead, stParse, stIndex, stCompress, stWrite, stVariables, stEdges, stCommunities, stPartition, stGraphStatistics,
+        ST_SIZE
+    };
+
+    typedef struct {
+        // updated by the owning thread only, atomic so that summing them up is not a data race;
+        // relaxed loads and stores compile to plain moves
+        std::atomic<uint64_t> counters[SC_SIZE];
+        std::atomic<uint64_t> timers_ns[ST_SIZE];
+        std::atomic<uint64_t> timers_count[ST_SIZE];
+        // hardware events during the phases, if the performance counters are open
+        std::atomic<uint64_t> timers_perf[ST_SIZE][PC_SIZE];
+    } statistics_shard_t;
+
+    typedef struct {
+        uint64_t counters[SC_SIZE];
+        uint64_t timers_ns[ST_SIZE];
+        uint64_t timers_count[ST_SIZE];
+        uint64_t timers_perf[ST_SIZE][PC_SIZE];
+        unsigned shards_size;
+    } statistics_t;
+
+    // the shard of the calling thread, once it has one
+    extern thread_local statistics_shard_t* __statistics_shard_;
+    statistics_shard_t& __statistics_shard_acquire();
+
+    // the shard of the calling thread
+    inline statistics_shard_t& statistics_shard() {
+        return __statistics_shard_ != nullptr ? *__statistics_shard_ : __statistics_shard_acquire();
+    };
+
+    inline void statistics_add(std::atomic<uint64_t>& value, const uint64_t delta) {
+        value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    };
+
+    // sums up the shards; concurrent updates may or may not be included
+    statistics_t statistics_get();
+    // zeroes all shards, expected while no other thread updates them
+    void statistics_reset();
+    const char* statistics_counter_name(const StatisticsCounter counter);
+    const char* statistics_timer_name(const StatisticsTimer timer);
+    // writes the statistics as a JSON object
+    void statistics_write_json(std::ostream& output, const statistics_t& statistics);
+
+#ifdef BAL_STATISTICS
+    static const constexpr bool STATISTICS_COUNTERS_ENABLED = true;
+#define _statistics_increment(counter) bal::statistics_add(bal::statistics_shard().counters[counter], 1)
+#else
+    static const constexpr bool STATISTICS_COUNTERS_ENABLED = false;
+#define _statistics_increment(counter)
+#endif
+};
+
+#endif /* statistics_hpp */
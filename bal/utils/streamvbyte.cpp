@@ -0,0 +1,129 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#include "streamvbyte.hpp"
+#include "cpudispatch.hpp"
+#include <string.h>
+
+#ifdef CPU_DISPATCH_X86
+#include <immintrin.h>
+#endif
+
+namespace bal {
+
+    typedef size_t (*stream_vbyte_decode_t)(const uint8_t* const control, const uint8_t* const data,
+                                            const size_t size, uint32_t* const values);
+
+    static inline uint32_t value_length(const uint32_t value) {
+        return value < (1 << 8) ? 1 : value < (1 << 16) ? 2 : value < (1 << 24) ? 3 : 4;
+    };
+
+    // values are stored little-endian whatever the host
+    static inline uint32_t read_value(const uint8_t* const data, const uint32_t length) {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < length; i++) {
+            value |= (uint32_t)data[i] << (i * 8);
+        };
+        return value;
+    };
+
+    size_t stream_vbyte_encode(const uint32_t* const values, const size_t size, uint8_t* const control, uint8_t* const data) {
+        memset(control, 0, stream_vbyte_control_size(size));
+        uint8_t* p_data = data;
+        for (size_t i = 0; i < size; i++) {
+            const uint32_t length = value_length(values[i]);
+            control[i >> 2] |= (length - 1) << ((i & 3) * 2);
+            for (uint32_t j = 0; j < length; j++) {
+                *p_data++ = (uint8_t)(values[i] >> (j * 8));
+            };
+        };
+        return p_data - data;
+    };
+
+    static size_t decode_scalar(const uint8_t* const control, const uint8_t* const data, const size_t size, uint32_t* const values) {
+        const uint8_t* p_data = data;
+        for (size_t i = 0; i < size; i++) {
+            const uint32_t length = ((control[i >> 2] >> ((i & 3) * 2)) & 3) + 1;
+            values[i] = read_value(p_data, length);
+            p_data += length;
+        };
+        return p_data - data;
+    };
+
+#ifdef CPU_DISPATCH_X86
+
+    // for each control byte, the number of data bytes and the shuffle that spreads them into 4 values
+    struct stream_vbyte_tables_t {
+        uint8_t lengths[256];
+        uint8_t shuffles[256][16];
+
+        stream_vbyte_tables_t() {
+            for (unsigned control = 0; control < 256; control++) {
+                uint8_t offset = 0;
+                for (unsigned k = 0; k < 4; k++) {
+                    const unsigned length = ((control >> (k * 2)) & 3) + 1;
+                    for (unsigned j = 0; j < 4; j++) {
+                        // 0x80 zeroes the byte
+                        shuffles[control][k * 4 + j] = j < length ? offset + j : 0x80;
+                    };
+                    offset += length;
+                };
+                lengths[control] = offset;
+            };
+        };
+    };
+
+    static const stream_vbyte_tables_t stream_vbyte_tables;
+
+    __attribute__((target("ssse3")))
+    static size_t decode_ssse3(const uint8_t* const control, const uint8_t* const data, const size_t size, uint32_t* const values) {
+        const uint8_t* p_data = data;
+        const size_t groups_size = size / 4;
+        for (size_t i = 0; i < groups_size; i++) {
+            const uint8_t group_control = control[i];
+            const __m128i group_data = _mm_loadu_si128((const __m128i*)p_data);
+            const __m128i shuffle = _mm_loadu_si128((const __m128i*)stream_vbyte_tables.shuffles[group_control]);
+            _mm_storeu_si128((__m128i*)(values + i * 4), _mm_shuffle_epi8(group_data, shuffle));
+            p_data += stream_vbyte_tables.lengths[group_control];
+        };
+        // the values of an incomplete group, their control bits start from the lowest ones
+        p_data += decode_scalar(control + groups_size, p_data, size - groups_size * 4, values + groups_size * 4);
+        return p_data - data;
+    };
+
+#endif
+
+    static const CpuDispatch<StreamVByteIsa, svbAuto, stream_vbyte_decode_t>::implementation_t STREAM_VBYTE_IMPLEMENTATIONS[] = {
+        {svbScalar, cfNone, &decode_scalar},
+#ifdef CPU_DISPATCH_X86
+        {svbSsse3, cfSsse3, &decode_ssse3},
+#endif
+    };
+
+    static CpuDispatch<StreamVByteIsa, svbAuto, stream_vbyte_decode_t> stream_vbyte_dispatch(STREAM_VBYTE_IMPLEMENTATIONS);
+
+    bool stream_vbyte_is_supported(const StreamVByteIsa isa) {
+        return stream_vbyte_dispatch.is_supported(isa);
+    };
+
+    bool stream_vbyte_select(const StreamVByteIsa isa) {
+        return stream_vbyte_dispatch.select(isa);
+    };
+
+    const char* stream_vbyte_name(const StreamVByteIsa isa) {
+        switch (isa) {
+            case svbAuto: return "auto";
+            case svbScalar: return "scalar";
+            case svbSsse3: return "ssse3";
+        };
+        return "unknown";
+    };
+
+    size_t stream_vbyte_decode(const uint8_t* const control, const uint8_t* const data, const size_t size, uint32_t* const values) {
+        return stream_vbyte_dispatch.kernel()(control, data, size, values);
+    };
+};
@@ -0,0 +1,50 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef streamvbyte_hpp
+#define streamvbyte_hpp
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace bal {
+
+    // Stream VByte encoding of 32 bit values, see Lemire, Kurz, Rupp, "Stream VByte: Faster
+    // Byte-Oriented Integer Compression", 2017
+    // each value takes 1 to 4 data bytes, little-endian; the lengths are kept apart in control
+    // bytes, 2 bits per value, the first value in the lowest bits; so 4 values are decoded at once
+    // with a single shuffle selected by their control byte
+    // the decoder is selected at runtime from those the CPU supports
+    // svbAuto resets the selection to the best supported one
+    enum StreamVByteIsa {svbAuto, svbScalar, svbSsse3};
+
+    bool stream_vbyte_is_supported(const StreamVByteIsa isa);
+    // intended for benchmarking; returns false if not supported, the selection is unchanged then
+    bool stream_vbyte_select(const StreamVByteIsa isa);
+    const char* stream_vbyte_name(const StreamVByteIsa isa);
+
+    // the decoder may read as many bytes beyond the encoded data
+    static const constexpr size_t STREAM_VBYTE_PADDING = 16;
+
+    inline size_t stream_vbyte_control_size(const size_t size) {
+        return (size + 3) / 4;
+    };
+
+    // largest number of data bytes for size values
+    inline size_t stream_vbyte_data_size_max(const size_t size) {
+        return size * 4;
+    };
+
+    // returns the number of data bytes written
+    // control must have room for stream_vbyte_control_size(size) bytes, data for stream_vbyte_data_size_max(size)
+    size_t stream_vbyte_encode(const uint32_t* const values, const size_t size, uint8_t* const control, uint8_t* const data);
+
+    // returns the number of data bytes read; data must be followed by STREAM_VBYTE_PADDING readable bytes
+    size_t stream_vbyte_decode(const uint8_t* const control, const uint8_t* const data, const size_t size, uint32_t* const values);
+};
+
+#endif /* streamvbyte_hpp */
@@ -0,0 +1,284 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#include "trace.hpp"
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+namespace bal {
+
+    namespace {
+
+        struct trace_state_t {
+            std::mutex mutex;
+            std::vector<trace_span_t> spans;
+            std::chrono::steady_clock::time_point origin;
+            unsigned threads_size = 0;
+        };
+
+        trace_state_t& trace_state() {
+            static trace_state_t state;
+            return state;
+        };
+
+        std::atomic<bool> trace_is_enabled_(false);
+        std::atomic<bool> trace_is_progress_enabled_(false);
+
+        // nesting depth of the spans of the calling thread
+        thread_local unsigned trace_depth = 0;
+        // assigned on the first span completed on the thread
+        thread_local unsigned trace_thread_index = UINT32_MAX;
+
+        uint64_t microseconds(const std::chrono::steady_clock::duration duration) {
+            return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        };
+
+        // the amount with a decimal prefix, e.g. 1.5 M
+        void print_amount(std::ostream& stream, const double value) {
+            static const char* const prefixes[] = {"", " K", " M", " G"};
+            unsigned index = 0;
+            double scaled = value;
+            while (scaled >= 1000.0 && index < 3) {
+                scaled /= 1000.0;
+                index++;
+            };
+            stream << std::fixed << std::setprecision(index > 0 ? 1 : 0) << scaled << prefixes[index];
+        };
+
+        void print_rates(std::ostream& stream, const trace_span_t& span) {
+            const double seconds = span.duration_us / 1000000.0;
+            if (span.bytes > 0 && seconds > 0) {
+                stream << ", " << std::fixed << std::setprecision(1) << span.bytes / 1000000.0 / seconds << " MB/s";
+            };
+            if (span.items > 0 && span.items_unit != nullptr) {
+                stream << ", ";
+                print_amount(stream, (double)span.items);
+                stream << " " << span.items_unit;
+                if (seconds > 0) {
+                    stream << ", ";
+                    print_amount(stream, span.items / seconds);
+                    stream << " " << span.items_unit << "/s";
+                };
+            };
+        };
+
+        // the events and their ratios, with the counters available
+        void print_perf(std::ostream& stream, const perf_counters_t& perf) {
+            if (perf_counters_is_available(pcCycles) && perf_counters_is_available(pcInstructions) && perf.values[pcCycles] > 0) {
+                stream << ", IPC " << std::fixed << std::setprecision(2) << (double)perf.values[pcInstructions] / perf.values[pcCycles];
+            };
+            static const PerfCounter misses[2][2] = {{pcCacheMisses, pcCacheReferences}, {pcBranchMisses, pcBranches}};
+            static const char* const names[2] = {"cache misses", "branch misses"};
+            for (unsigned i = 0; i < 2; i++) {
+                if (perf_counters_is_available(misses[i][0])) {
+                    stream << ", ";
+                    print_amount(stream, (double)perf.values[misses[i][0]]);
+                    stream << " " << names[i];
+                    if (perf_counters_is_available(misses[i][1]) && perf.values[misses[i][1]] > 0) {
+                        stream << " (" << std::fixed << std::setprecision(1);
+                        stream << 100.0 * perf.values[misses[i][0]] / perf.values[misses[i][1]] << "%)";
+                    };
+                };
+            };
+            if (perf_counters_is_available(pcPageFaults)) {
+                stream << ", ";
+                print_amount(stream, (double)perf.values[pcPageFaults]);
+                stream << " page faults";
+            };
+        };
+
+        void write_json_string(std::ostream& stream, const char* const value) {
+            stream << '"';
+            for (const char* p = value; *p != 0; p++) {
+                if (*p == '"' || *p == '\\') {
+                    stream << '\\';
+                };
+                stream << *p;
+            };
+            stream << '"';
+        };
+    };
+
+    void trace_enable(const bool is_progress) {
+        trace_state_t& state = trace_state();
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.spans.clear();
+            state.origin = std::chrono::steady_clock::now();
+        };
+        trace_is_progress_enabled_ = is_progress;
+        trace_is_enabled_ = true;
+    };
+
+    bool trace_is_enabled() {
+        return trace_is_enabled_.load(std::memory_order_relaxed);
+    };
+
+    bool trace_is_progress_enabled() {
+        return trace_is_progress_enabled_.load(std::memory_order_relaxed);
+    };
+
+    std::vector<trace_span_t> trace_spans() {
+        trace_state_t& state = trace_state();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        return state.spans;
+    };
+
+    uint64_t trace_cpu_time_us() {
+        timespec value;
+        if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &value) != 0) {
+            return 0;
+        };
+        return (uint64_t)value.tv_sec * 1000000 + value.tv_nsec / 1000;
+    };
+
+    // 0 where /proc is not available
+    uint64_t trace_rss_bytes() {
+        uint64_t rss_bytes = 0;
+        FILE* const file = fopen("/proc/self/statm", "r");
+        if (file != nullptr) {
+            unsigned long size = 0;
+            unsigned long resident = 0;
+            if (fscanf(file, "%lu %lu", &size, &resident) == 2) {
+                rss_bytes = (uint64_t)resident * (uint64_t)sysconf(_SC_PAGESIZE);
+            };
+            fclose(file);
+        };
+        return rss_bytes;
+    };
+
+    // spans end before their parents, so they are listed by start time to put the parents first
+    void trace_print(std::ostream& stream) {
+        std::vector<trace_span_t> spans = trace_spans();
+        std::stable_sort(spans.begin(), spans.end(), [](const trace_span_t& lhs, const trace_span_t& rhs) {
+            return lhs.start_us < rhs.start_us;
+        });
+        const std::ios::fmtflags flags = stream.flags();
+        const std::streamsize precision = stream.precision();
+        for (const trace_span_t& span: spans) {
+            stream << std::string(2 + span.depth * 2, ' ') << statistics_timer_name(span.timer) << ": ";
+            stream << std::fixed << std::setprecision(3) << span.duration_us / 1000000.0 << " s, CPU ";
+            stream << span.cpu_us / 1000000.0 << " s";
+            print_rates(stream, span);
+            if (span.rss_bytes > 0) {
+                stream << ", RSS " << std::setprecision(1) << span.rss_bytes / 1000000.0 << " MB";
+            };
+            print_perf(stream, span.perf);
+            stream << std::endl;
+        };
+        stream.flags(flags);
+        stream.precision(precision);
+    };
+
+    // the Trace Event Format, opens in chrome://tracing or Perfetto
+    void trace_write_chrome_json(std::ostream& stream) {
+        const std::vector<trace_span_t> spans = trace_spans();
+        stream << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+        for (size_t i = 0; i < spans.size(); i++) {
+            const trace_span_t& span = spans[i];
+            stream << (i > 0 ? ",\n" : "\n") << "{\"name\": ";
+            write_json_string(stream, statistics_timer_name(span.timer));
+            stream << ", \"cat\": \"cgraph\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << span.thread_index;
+            stream << ", \"ts\": " << span.start_us << ", \"dur\": " << span.duration_us;
+            stream << ", \"args\": {\"cpu_ms\": " << span.cpu_us / 1000 << ", \"bytes\": " << span.bytes;
+            stream << ", \"items\": " << span.items << ", \"items_unit\": ";
+            write_json_string(stream, span.items_unit != nullptr ? span.items_unit : "");
+            stream << ", \"rss_bytes\": " << span.rss_bytes;
+            for (unsigned j = 0; j < PC_SIZE; j++) {
+                if (perf_counters_is_available((PerfCounter)j)) {
+                    stream << ", \"" << perf_counter_name((PerfCounter)j) << "\": " << span.perf.values[j];
+                };
+            };
+            stream << "}}";
+        };
+        stream << "\n]}\n";
+    };
+
+    TraceSpan::TraceSpan(const StatisticsTimer timer, const char* const items_unit):
+        timer_(timer), items_unit_(items_unit), start_(std::chrono::steady_clock::now()),
+        next_progress_(start_ + std::chrono::seconds(TRACE_PROGRESS_INTERVAL_S)), is_recorded_(trace_is_enabled()),
+        is_perf_counted_(perf_counters_is_open()) {
+        if (is_perf_counted_) {
+            perf_counters_read(perf_start_);
+        };
+        if (is_recorded_) {
+            cpu_start_us_ = trace_cpu_time_us();
+            depth_ = trace_depth++;
+        };
+    };
+
+    TraceSpan::~TraceSpan() {
+        statistics_shard_t& shard = statistics_shard();
+        statistics_add(shard.timers_ns[timer_],
+                       std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count());
+        statistics_add(shard.timers_count[timer_], 1);
+        perf_counters_t perf = {};
+        if (is_perf_counted_) {
+            perf_counters_read(perf);
+            for (unsigned i = 0; i < PC_SIZE; i++) {
+                // the values are estimates while the counters are multiplexed
+                perf.values[i] = perf.values[i] > perf_start_.values[i] ? perf.values[i] - perf_start_.values[i] : 0;
+                statistics_add(shard.timers_perf[timer_][i], perf.values[i]);
+            };
+        };
+        if (is_recorded_) {
+            trace_depth--;
+            record(perf);
+        };
+    };
+
+    void TraceSpan::record(const perf_counters_t& perf) {
+        const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        trace_span_t span;
+        span.timer = timer_;
+        span.depth = depth_;
+        span.cpu_us = trace_cpu_time_us() - cpu_start_us_;
+        span.bytes = bytes_;
+        span.items = items_;
+        span.items_unit = items_unit_;
+        span.rss_bytes = trace_rss_bytes();
+        span.perf = perf;
+
+        trace_state_t& state = trace_state();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (trace_thread_index == UINT32_MAX) {
+            trace_thread_index = state.threads_size++;
+        };
+        span.thread_index = trace_thread_index;
+        span.start_us = start_ > state.origin ? microseconds(start_ - state.origin) : 0;
+        span.duration_us = microseconds(end - start_);
+        state.spans.push_back(span);
+    };
+
+    void TraceSpan::print_progress(const uint64_t bytes_total) {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        next_progress_ = now + std::chrono::seconds(TRACE_PROGRESS_INTERVAL_S);
+        trace_span_t span = {};
+        span.duration_us = microseconds(now - start_);
+        span.bytes = bytes_;
+        span.items = items_;
+        span.items_unit = items_unit_;
+
+        std::ostringstream line;
+        line << "Progress: " << statistics_timer_name(timer_) << " " << std::fixed << std::setprecision(1);
+        line << span.duration_us / 1000000.0 << " s";
+        if (bytes_total > 0) {
+            line << ", " << bytes_ / 1000000.0 << " of " << bytes_total / 1000000.0 << " MB (";
+            line << std::setprecision(0) << 100.0 * bytes_ / bytes_total << "%)";
+        };
+        print_rates(line, span);
+        std::cerr << line.str() << std::endl;
+    };
+};
@@ -0,0 +1,92 @@
+//
+//  Boolean Algebra Library (BAL)
+//  https://cgen.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef trace_hpp
+#define trace_hpp
+
+#include <stdint.h>
+#include <chrono>
+#include <ostream>
+#include <vector>
+#include "statistics.hpp"
+#include "perfcounters.hpp"
+
+namespace bal {
+
+    // a completed span, times in microseconds since tracing is enabled
+    typedef struct {
+        StatisticsTimer timer;
+        unsigned thread_index;
+        unsigned depth;
+        uint64_t start_us;
+        uint64_t duration_us;
+        // CPU time of the process during the span, all threads included
+        uint64_t cpu_us;
+        uint64_t bytes;
+        uint64_t items;
+        const char* items_unit;
+        // resident set size at the end of the span
+        uint64_t rss_bytes;
+        // hardware events of the process during the span, if the performance counters are open
+        perf_counters_t perf;
+    } trace_span_t;
+
+    // spans are recorded once enabled; is_progress also prints a progress line for long spans
+    void trace_enable(const bool is_progress);
+    bool trace_is_enabled();
+    bool trace_is_progress_enabled();
+    std::vector<trace_span_t> trace_spans();
+    // a line per span with its throughput, nested spans indented
+    void trace_print(std::ostream& stream);
+    // Chrome trace_event format, complete events with the figures in args
+    void trace_write_chrome_json(std::ostream& stream);
+
+    uint64_t trace_cpu_time_us();
+    uint64_t trace_rss_bytes();
+
+    static const constexpr unsigned TRACE_PROGRESS_INTERVAL_S = 2;
+
+    // a named phase; adds its time to the statistics timer of the same name and,
+    // if tracing is enabled, records the span
+    // bytes and items processed are set by the phase as it learns them, items_unit names the items
+    class TraceSpan {
+    private:
+        const StatisticsTimer timer_;
+        const char* const items_unit_;
+        const std::chrono::steady_clock::time_point start_;
+        std::chrono::steady_clock::time_point next_progress_;
+        const bool is_recorded_;
+        const bool is_perf_counted_;
+        perf_counters_t perf_start_;
+        uint64_t cpu_start_us_ = 0;
+        unsigned depth_ = 0;
+        uint64_t bytes_ = 0;
+        uint64_t items_ = 0;
+
+        void record(const perf_counters_t& perf);
+        void print_progress(const uint64_t bytes_total);
+
+    public:
+        TraceSpan(const StatisticsTimer timer, const char* const items_unit = nullptr);
+        ~TraceSpan();
+
+        void set_bytes(const uint64_t value) { bytes_ = value; };
+        void set_items(const uint64_t value) { items_ = value; };
+
+        // reports the figures so far, printed at most once per TRACE_PROGRESS_INTERVAL_S if enabled
+        // bytes_total is 0 if not known
+        inline void progress(const uint64_t items, const uint64_t bytes, const uint64_t bytes_total) {
+            items_ = items;
+            bytes_ = bytes;
+            if (is_recorded_ && trace_is_progress_enabled() && std::chrono::steady_clock::now() >= next_progress_) {
+                print_progress(bytes_total);
+            };
+        };
+    };
+};
+
+#endif /* trace_hpp */
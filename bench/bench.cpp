@@ -0,0 +1,461 @@
+//
+//  CGraph - Convertor from DIMACS CNF to GraphML format
+//  https://www.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "streamable.hpp"
+#include "textscan.hpp"
+#include "cnf.hpp"
+#include "cnfcompressed.hpp"
+#include "dimacs.hpp"
+#include "graphml.hpp"
+#include "variableincidencegraph.hpp"
+#include "louvain.hpp"
+#include "graphstatistics.hpp"
+#include "intersection.hpp"
+#include "benchreport.hpp"
+#include "cnfgenerator.hpp"
+
+using namespace bal;
+
+// microbenchmarks for the performance critical parts of CGraph
+// data is generated with a fixed seed so the results are comparable between runs
+
+namespace {
+
+    BenchReport report;
+
+    // clause lines as written by typical encoders, 2 to 5 literals per clause
+    std::string generate_clauses_text(const unsigned clauses_size, const unsigned variables_size) {
+        std::mt19937 random(1);
+        std::uniform_int_distribution<unsigned> clause_size(2, 5);
+        std::uniform_int_distribution<unsigned> variable(1, variables_size);
+        std::ostringstream text;
+        for (unsigned i = 0; i < clauses_size; i++) {
+            const unsigned size = clause_size(random);
+            for (unsigned j = 0; j < size; j++) {
+                const unsigned value = variable(random);
+                text << ((value & 1) ? "-" : "") << value << ' ';
+            };
+            text << "0\n";
+        };
+        return text.str();
+    };
+
+    // reads clause lines from the buffer into a checksum of the values
+    class ClausesTextReader: public TextStreamReader<uint64_t> {
+    private:
+        bool is_scan_;
+        std::vector<int32_t> values_;
+
+    public:
+        ClausesTextReader(std::istream& stream, const std::string& text, const bool is_scan):
+            TextStreamReader<uint64_t>(stream, text.data(), text.size()), is_scan_(is_scan) {};
+
+        virtual void read(uint64_t& checksum) override {
+            checksum = 0;
+            while (!is_eof()) {
+                values_.clear();
+                if (!is_scan_ || !read_sint32_sequence(values_)) {
+                    // token by token
+                    while (!is_eol()) {
+                        skip_space();
+                        if (is_symbol('0')) {
+                            break;
+                        };
+                        values_.push_back(read_sint32());
+                    };
+                    skip_space();
+                    read_symbol('0');
+                };
+                skip_space();
+                read_eol();
+                for (auto value: values_) {
+                    checksum = checksum * 31 + (uint32_t)value;
+                };
+            };
+        };
+    };
+
+    template<typename TASK_T>
+    double measure_ms(TASK_T task) {
+        const auto start = std::chrono::steady_clock::now();
+        task();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    void bench_text_scan() {
+        const std::string text = generate_clauses_text(2000000, 1000000);
+        const double text_mb = text.size() / 1048576.0;
+        std::cout << "DIMACS clauses text: " << text_mb << " MB" << std::endl;
+
+        uint64_t checksum_expected = 0;
+        std::istringstream stream;
+        const TextScanIsa isa_list[] = {tsiScalar, tsiSse42, tsiAvx2};
+        for (const TextScanIsa isa: isa_list) {
+            if (!text_scan_select(isa)) {
+                continue;
+            };
+            for (const bool is_scan: {false, true}) {
+                uint64_t checksum = 0;
+                const double ms = measure_ms([&]() {
+                    ClausesTextReader reader(stream, text, is_scan);
+                    reader.read(checksum);
+                });
+                if (checksum_expected == 0) {
+                    checksum_expected = checksum;
+                };
+                std::cout << "  " << text_scan_name(isa) << (is_scan ? ", sequence scan: " : ", token by token: ");
+                std::cout << ms << " ms, " << text_mb * 1000.0 / ms << " MB/s";
+                report.add("text_scan", std::string(text_scan_name(isa)) + (is_scan ? ", sequence scan" : ", token by token"),
+                           text.size(), ms, {{"MB/s", text_mb * 1000.0 / ms}});
+                std::cout << (checksum == checksum_expected ? "" : ", CHECKSUM MISMATCH") << std::endl;
+            };
+        };
+        text_scan_select(tsiAuto);
+    };
+
+    // Cnf::normalize_clause as it was with std::sort for every clause
+    clause_size_t normalize_clause_std_sort(uint32_t* const literals, const clause_size_t literals_size) {
+        std::sort(literals, literals + literals_size);
+        clause_size_t validated_size = 1;
+        for (auto i = 1; i < literals_size; i++) {
+            if (literals[i] == literals[validated_size - 1]) {
+                continue;
+            } else if ((literals[i] ^ 0x1) == literals[validated_size - 1]) {
+                return 0;
+            } else {
+                literals[validated_size++] = literals[i];
+            };
+        };
+        return validated_size;
+    };
+
+    // clauses in the Cnf layout, each literals list preceded by its size
+    // clause sizes follow the given weights, index i for size i
+    std::vector<uint32_t> generate_clauses(const unsigned clauses_size, const unsigned variables_size,
+                                           const std::vector<double>& size_weights) {
+        std::mt19937 random(1);
+        std::discrete_distribution<unsigned> clause_size(size_weights.begin(), size_weights.end());
+        std::uniform_int_distribution<unsigned> variable(1, variables_size);
+        std::vector<uint32_t> clauses;
+        for (unsigned i = 0; i < clauses_size; i++) {
+            const unsigned size = std::max(1u, clause_size(random));
+            clauses.push_back(size);
+            for (unsigned j = 0; j < size; j++) {
+                const unsigned value = variable(random);
+                clauses.push_back((value + 1) << 1 | (random() & 1));
+            };
+        };
+        return clauses;
+    };
+
+    // normalizes the clauses in place
+    template<typename NORMALIZE_F>
+    uint64_t normalize_clauses(std::vector<uint32_t>& clauses, NORMALIZE_F normalize) {
+        uint64_t checksum = 0;
+        for (size_t offset = 0; offset < clauses.size(); offset += clauses[offset] + 1) {
+            uint32_t* const literals = clauses.data() + offset + 1;
+            const clause_size_t size = normalize(literals, clauses[offset]);
+            checksum = checksum * 31 + size;
+            for (clause_size_t i = 0; i < size; i++) {
+                checksum = checksum * 31 + literals[i];
+            };
+        };
+        return checksum;
+    };
+
+    void bench_normalize_clause() {
+        struct distribution_t {
+            const char* name;
+            unsigned variables_size;
+            std::vector<double> size_weights;
+        };
+        // mostly binary and ternary clauses with a tail of long ones, as produced by Tseitin encodings;
+        // uniform random 3-SAT; a mix of medium sizes as in cardinality and k-SAT instances
+        const distribution_t distributions[] = {
+            {"industrial", 1000000, {0, 2, 50, 30, 6, 3, 2, 2, 1, 1, 1, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5}},
+            {"random 3-SAT", 100000, {0, 0, 0, 1}},
+            {"5..12 literals", 1000, {0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1}}
+        };
+        std::cout << "Clause normalization, 2000000 clauses:" << std::endl;
+        for (const auto& distribution: distributions) {
+            std::vector<uint32_t> clauses_std = generate_clauses(2000000, distribution.variables_size, distribution.size_weights);
+            std::vector<uint32_t> clauses_network = clauses_std;
+            uint64_t checksum_std = 0;
+            uint64_t checksum_network = 0;
+            const double ms_std = measure_ms([&]() {
+                checksum_std = normalize_clauses(clauses_std, normalize_clause_std_sort);
+            });
+            const double ms_network = measure_ms([&]() {
+                checksum_network = normalize_clauses(clauses_network, Cnf::normalize_clause);
+            });
+            std::cout << "  " << distribution.name << ": std::sort " << ms_std << " ms, sorting networks " << ms_network << " ms";
+            report.add("normalize_clause", std::string(distribution.name) + ", std::sort", 2000000, ms_std);
+            report.add("normalize_clause", std::string(distribution.name) + ", sorting networks", 2000000, ms_network);
+            std::cout << (checksum_std == checksum_network ? "" : ", CHECKSUM MISMATCH") << std::endl;
+        };
+    };
+
+    // normalized clauses in the Cnf layout, empty ones dropped, as the formula keeps them
+    std::vector<uint32_t> generate_normalized_clauses(const unsigned clauses_size, const unsigned variables_size,
+                                                      const std::vector<double>& size_weights) {
+        std::vector<uint32_t> clauses = generate_clauses(clauses_size, variables_size, size_weights);
+        std::vector<uint32_t> normalized;
+        for (size_t offset = 0; offset < clauses.size(); offset += clauses[offset] + 1) {
+            uint32_t* const literals = clauses.data() + offset + 1;
+            const clause_size_t size = Cnf::normalize_clause(literals, clauses[offset]);
+            if (size > 0) {
+                normalized.push_back(size);
+                normalized.insert(normalized.end(), literals, literals + size);
+            };
+        };
+        return normalized;
+    };
+
+    void bench_compressed_clauses() {
+        // random variables make the worst case for delta encoding, local ones the typical one
+        const unsigned variables_sizes[] = {1000000, 1000};
+        std::cout << "Compressed clauses, 2000000 clauses:" << std::endl;
+        for (const unsigned variables_size: variables_sizes) {
+            const std::vector<uint32_t> clauses = generate_normalized_clauses(2000000, variables_size, {0, 2, 50, 30, 6, 3, 2, 2, 1, 1});
+            CnfCompressedClauses compressed;
+            const double ms_encode = measure_ms([&]() {
+                compressed.encode(clauses.data(), (uint32_t)clauses.size());
+            });
+            const double mb = clauses.size() * sizeof(uint32_t) / 1048576.0;
+            std::cout << "  " << variables_size << " variables: " << mb << " MB, ";
+            std::cout << compressed.memory_size() / 1048576.0 << " MB compressed, encoded in " << ms_encode << " ms" << std::endl;
+            const std::string case_name = std::to_string(variables_size) + " variables";
+            report.add("compressed_clauses_encode", case_name, clauses.size() * sizeof(uint32_t), ms_encode,
+                       {{"ratio", clauses.size() * sizeof(uint32_t) / (double)compressed.memory_size()}});
+
+            std::vector<uint32_t> words;
+            const StreamVByteIsa isa_list[] = {svbScalar, svbSsse3};
+            for (const StreamVByteIsa isa: isa_list) {
+                if (!stream_vbyte_select(isa)) {
+                    continue;
+                };
+                bool is_match = true;
+                const double ms = measure_ms([&]() {
+                    size_t offset = 0;
+                    for (uint32_t block = 0; block < compressed.blocks_size(); block++) {
+                        const uint32_t words_size = compressed.block_words_size(block);
+                        words.resize(words_size);
+                        compressed.decode_block(block, words.data());
+                        is_match = is_match && std::equal(words.begin(), words.end(), clauses.begin() + offset);
+                        offset += words_size;
+                    };
+                });
+                std::cout << "    " << stream_vbyte_name(isa) << " decoding: " << ms << " ms, " << mb * 1000.0 / ms << " MB/s";
+                report.add("compressed_clauses_decode", case_name + ", " + stream_vbyte_name(isa),
+                           clauses.size() * sizeof(uint32_t), ms, {{"MB/s", mb * 1000.0 / ms}});
+                std::cout << (is_match ? "" : ", MISMATCH") << std::endl;
+            };
+            stream_vbyte_select(svbAuto);
+        };
+    };
+
+    // discards the output, counting the bytes written
+    class NullStreamBuffer: public std::streambuf {
+    private:
+        uint64_t size_ = 0;
+
+    protected:
+        virtual int_type overflow(const int_type c) override {
+            size_ += 1;
+            return traits_type::not_eof(c);
+        };
+
+        virtual std::streamsize xsputn(const char* const, const std::streamsize size) override {
+            size_ += size;
+            return size;
+        };
+
+    public:
+        uint64_t size() const { return size_; };
+    };
+
+    template<typename WRITER_T, typename... Args>
+    void bench_write(const char* const benchmark, const std::string& case_name, const Cnf& cnf, Args... args) {
+        NullStreamBuffer buffer;
+        std::ostream stream(&buffer);
+        const double ms = measure_ms([&]() {
+            WRITER_T writer(stream, args...);
+            writer.write(cnf);
+        });
+        const double mb = buffer.size() / 1048576.0;
+        std::cout << "    " << benchmark << ": " << ms << " ms, " << mb << " MB, " << mb * 1000.0 / ms << " MB/s" << std::endl;
+        report.add(benchmark, case_name, buffer.size(), ms, {{"MB/s", mb * 1000.0 / ms}});
+    };
+
+    // the stages of the conversion on a generated formula, one thread
+    // a large clause makes about 200 times as many edges as a ternary one, so 64 times fewer are generated
+    void bench_pipeline(const CnfGeneratorKind kind, const uint32_t scale) {
+        const uint32_t clauses_size = kind == cgkLarge ? std::max(1u, scale / 64) : scale;
+        const std::string case_name = std::string(CnfGenerator::name(kind)) + ", " + std::to_string(clauses_size) + " clauses";
+        std::cout << "  " << case_name << std::endl;
+
+        std::ostringstream text_stream;
+        CnfGenerator(kind, clauses_size).write_dimacs(text_stream, clauses_size);
+        const std::string text = text_stream.str();
+        const double text_mb = text.size() / 1048576.0;
+
+        // the same clauses, encoded as the reader does
+        std::vector<std::vector<literalid_t>> clauses(clauses_size);
+        CnfGenerator generator(kind, clauses_size);
+        std::vector<int32_t> literals;
+        for (auto& clause: clauses) {
+            generator.next(literals);
+            for (const int32_t literal: literals) {
+                clause.push_back(literal_t::signed_encode(literal));
+            };
+        };
+
+        Cnf cnf;
+        std::istringstream stream;
+        const double ms_parse = measure_ms([&]() {
+            DimacsStreamReader reader(stream, text.data(), text.size());
+            reader.read(cnf);
+        });
+        std::cout << "    dimacs_parse: " << ms_parse << " ms, " << text_mb * 1000.0 / ms_parse << " MB/s" << std::endl;
+        report.add("dimacs_parse", case_name, text.size(), ms_parse, {{"MB/s", text_mb * 1000.0 / ms_parse}});
+
+        // one by one, as the formula is built by encoders; then the same clauses again, all of them
+        // are found in the index as duplicates or merged into aggregated ones
+        Cnf appended;
+        appended.initialize(generator.variables_size(), clauses_size);
+        for (const bool is_lookup: {false, true}) {
+            const double ms = measure_ms([&]() {
+                for (const auto& clause: clauses) {
+                    appended.append_clause(clause.data(), (clause_size_t)clause.size());
+                };
+            });
+            const char* const benchmark = is_lookup ? "index_lookup" : "append_clause";
+            std::cout << "    " << benchmark << ": " << ms << " ms, " << clauses_size / ms / 1000.0 << " M clauses/s" << std::endl;
+            report.add(benchmark, case_name, clauses_size, ms, {{"M clauses/s", clauses_size / ms / 1000.0}});
+        };
+
+        VariableIncidenceGraph graph;
+        const double ms_graph = measure_ms([&]() {
+            graph.build(cnf);
+        });
+        std::cout << "    edge_dedup: " << ms_graph << " ms, " << graph.edges_size() << " edges" << std::endl;
+        report.add("edge_dedup", case_name, graph.edges_size(), ms_graph, {{"M edges/s", graph.edges_size() / ms_graph / 1000.0}});
+
+        Louvain louvain;
+        const double ms_louvain = measure_ms([&]() {
+            louvain.run(graph);
+        });
+        std::cout << "    louvain: " << ms_louvain << " ms, " << louvain.communities_size() << " communities, modularity " << louvain.modularity() << std::endl;
+        report.add("louvain", case_name, graph.nodes_size(), ms_louvain, {{"M edges/s", graph.edges_size() / ms_louvain / 1000.0}, {"modularity", louvain.modularity()}});
+
+        // triangles dominate, they are counted by intersecting rows with each implementation
+        const IntersectionIsa isa_list[] = {iiScalar, iiSse2, iiAvx2};
+        for (const IntersectionIsa isa: isa_list) {
+            if (!intersection_select(isa)) {
+                continue;
+            };
+            GraphStatistics statistics;
+            const double ms = measure_ms([&]() {
+                statistics.run(graph);
+            });
+            std::cout << "    graph_statistics, " << intersection_name(isa) << ": " << ms << " ms, " << statistics.triangles_size() << " triangles" << std::endl;
+            report.add("graph_statistics", case_name + ", " + intersection_name(isa), graph.edges_size(), ms,
+                       {{"M edges/s", graph.edges_size() / ms / 1000.0}});
+        };
+        intersection_select(iiAuto);
+
+        bench_write<GraphMLStreamWriter>("graphml_write", case_name, cnf);
+        bench_write<GraphMLWeightedStreamWriter>("graphml_weighted_write", case_name, cnf, 1u);
+        bench_write<DimacsStreamWriter>("dimacs_write", case_name, cnf);
+    };
+
+    void bench_pipelines(const std::vector<uint32_t>& scales) {
+        std::cout << "Conversion stages on generated formulas:" << std::endl;
+        for (const uint32_t scale: scales) {
+            for (const CnfGeneratorKind kind: {cgkRandom, cgkCommunity, cgkLarge}) {
+                bench_pipeline(kind, scale);
+            };
+        };
+    };
+
+    bool parse_uint(const char* const value, uint64_t& result) {
+        char* value_end = nullptr;
+        result = strtoull(value, &value_end, 10);
+        return value_end != value && *value_end == 0;
+    };
+
+    void print_usage() {
+        std::cout << "Usage:" << std::endl;
+        std::cout << "  cgraph_bench [--json <file name>] [<clauses> ...]" << std::endl;
+        std::cout << "  cgraph_bench --generate <kind> <clauses> [<seed>] <output file name>" << std::endl;
+        std::cout << "  json - also write the results as JSON" << std::endl;
+        std::cout << "  clauses - formula sizes for the conversion stages, 100000 and 1000000 by default" << std::endl;
+        std::cout << "  generate - write a generated DIMACS formula: random, community or large; seed is 1 by default" << std::endl;
+    };
+
+    int generate(const int argc, const char* argv[]) {
+        CnfGeneratorKind kind;
+        uint64_t clauses_size = 0;
+        uint64_t seed = 1;
+        if ((argc != 5 && argc != 6) || !CnfGenerator::parse_kind(argv[2], kind) || !parse_uint(argv[3], clauses_size) ||
+            clauses_size > UINT32_MAX || (argc == 6 && !parse_uint(argv[4], seed))) {
+            print_usage();
+            return 1;
+        };
+        std::ofstream file(argv[argc - 1]);
+        if (!file.is_open()) {
+            std::cout << "Error: cannot open the file \"" << argv[argc - 1] << "\"." << std::endl;
+            return 1;
+        };
+        CnfGenerator(kind, (uint32_t)clauses_size, seed).write_dimacs(file, (uint32_t)clauses_size);
+        return 0;
+    };
+};
+
+int main(int argc, const char * argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--generate") == 0) {
+        return generate(argc, argv);
+    };
+
+    const char* json_file_name = nullptr;
+    std::vector<uint32_t> scales;
+    for (int i = 1; i < argc; i++) {
+        uint64_t scale = 0;
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_file_name = argv[++i];
+        } else if (parse_uint(argv[i], scale) && scale > 0 && scale <= UINT32_MAX) {
+            scales.push_back((uint32_t)scale);
+        } else {
+            print_usage();
+            return 1;
+        };
+    };
+    if (scales.empty()) {
+        scales = {100000, 1000000};
+    };
+
+    std::cout << "CGraph benchmarks" << std::endl;
+    bench_text_scan();
+    bench_normalize_clause();
+    bench_compressed_clauses();
+    bench_pipelines(scales);
+    if (json_file_name != nullptr && !report.write_json(json_file_name)) {
+        std::cout << "Error: cannot write the file \"" << json_file_name << "\"." << std::endl;
+        return 1;
+    };
+    return 0;
+}
@@ -0,0 +1,110 @@
+//
+//  CGraph - Convertor from DIMACS CNF to GraphML format
+//  https://www.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef benchreport_hpp
+#define benchreport_hpp
+
+#include <stdint.h>
+#include <time.h>
+#include <fstream>
+#include <iomanip>
+#include <locale>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// benchmark results collected for writing as JSON, so that runs can be compared over time
+//   {"tool": "cgraph_bench", "format": 1, "date": ..., "threads": ..., "clauses_index": ...,
+//    "results": [{"benchmark": ..., "case": ..., "size": ..., "ms": ..., "metrics": {...}}, ...]}
+// size is the number of items processed, e.g. clauses or bytes, as the benchmark defines
+// metrics are derived figures such as rates and ratios
+class BenchReport {
+public:
+    typedef std::vector<std::pair<std::string, double>> metrics_t;
+
+private:
+    typedef struct {
+        std::string benchmark;
+        std::string case_name;
+        uint64_t size;
+        double ms;
+        metrics_t metrics;
+    } result_t;
+
+    std::vector<result_t> results_;
+
+    static std::string quote(const std::string& value) {
+        std::string result = "\"";
+        for (const char c: value) {
+            if (c == '"' || c == '\\') {
+                result += '\\';
+            };
+            result += c;
+        };
+        return result + "\"";
+    };
+
+    // JSON has no representation for infinity, e.g. a rate measured over 0 ms
+    // 17 significant digits restore the double exactly, the classic locale keeps the decimal point
+    static std::string number(const double value) {
+        if (!(value == value && value - value == 0)) {
+            return "null";
+        };
+        std::ostringstream stream;
+        stream.imbue(std::locale::classic());
+        stream << std::setprecision(17) << value;
+        return stream.str();
+    };
+
+public:
+    void add(const std::string& benchmark, const std::string& case_name, const uint64_t size, const double ms,
+             const metrics_t& metrics = metrics_t()) {
+        results_.push_back({benchmark, case_name, size, ms, metrics});
+    };
+
+    bool write_json(const char* const file_name) const {
+        std::ofstream file(file_name);
+        if (!file.is_open()) {
+            return false;
+        };
+        // integers are written without digit grouping whatever the global locale
+        file.imbue(std::locale::classic());
+        char date[32];
+        const time_t now = time(nullptr);
+        strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+        file << "{\n";
+        file << "  \"tool\": \"cgraph_bench\",\n";
+        file << "  \"format\": 1,\n";
+        file << "  \"date\": " << quote(date) << ",\n";
+        file << "  \"threads\": " << std::thread::hardware_concurrency() << ",\n";
+#ifdef BAL_CNF_HASH_INDEX
+        file << "  \"clauses_index\": \"hash\",\n";
+#else
+        file << "  \"clauses_index\": \"tree\",\n";
+#endif
+        file << "  \"results\": [";
+        for (size_t i = 0; i < results_.size(); i++) {
+            const result_t& result = results_[i];
+            file << (i > 0 ? ",\n" : "\n") << "    {\"benchmark\": " << quote(result.benchmark);
+            file << ", \"case\": " << quote(result.case_name);
+            file << ", \"size\": " << result.size;
+            file << ", \"ms\": " << number(result.ms);
+            file << ", \"metrics\": {";
+            for (size_t j = 0; j < result.metrics.size(); j++) {
+                file << (j > 0 ? ", " : "") << quote(result.metrics[j].first) << ": " << number(result.metrics[j].second);
+            };
+            file << "}}";
+        };
+        file << "\n  ]\n}\n";
+        return file.good();
+    };
+};
+
+#endif /* benchreport_hpp */
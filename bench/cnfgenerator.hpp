@@ -0,0 +1,133 @@
+//
+//  CGraph - Convertor from DIMACS CNF to GraphML format
+//  https://www.sophisticatedways.net
+//  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+//  Published under terms of MIT license.
+//
+
+#ifndef cnfgenerator_hpp
+#define cnfgenerator_hpp
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// synthetic formulas for benchmarking, the same for the same kind, size and seed on any host
+// std::mt19937_64 is fully specified by the standard, the distributions are not, so the values
+// are derived from its output directly
+//   random - uniform random 3-SAT at the satisfiability threshold, 4.26 clauses per variable
+//   community - variables are split into communities of 64, 9 of 10 clauses take all their
+//     variables from one community, the rest from anywhere; 2 to 5 literals per clause,
+//     mostly 2 and 3 as in Tseitin encodings
+//   large - 8 to 64 literals per clause over all variables, 2 clauses per variable
+enum CnfGeneratorKind {cgkRandom, cgkCommunity, cgkLarge};
+
+class CnfGenerator {
+public:
+    static const constexpr uint32_t COMMUNITY_SIZE = 64;
+
+private:
+    const CnfGeneratorKind kind_;
+    const uint32_t variables_size_;
+    std::mt19937_64 random_;
+
+    // uniform in [0, size), the bias is negligible for the sizes generated
+    inline uint32_t next_uint32(const uint32_t size) {
+        return (uint32_t)(((random_() >> 32) * size) >> 32);
+    };
+
+    // size distinct variables from [first, first + range_size), DIMACS numbers with random signs
+    void next_literals(const uint32_t size, const uint32_t first, const uint32_t range_size, std::vector<int32_t>& literals) {
+        literals.clear();
+        while (literals.size() < size) {
+            const int32_t variable = (int32_t)(first + next_uint32(range_size) + 1);
+            bool is_duplicate = false;
+            for (const int32_t literal: literals) {
+                is_duplicate = is_duplicate || literal == variable || literal == -variable;
+            };
+            if (!is_duplicate) {
+                literals.push_back((random_() & 1) ? -variable : variable);
+            };
+        };
+    };
+
+public:
+    CnfGenerator(const CnfGeneratorKind kind, const uint32_t clauses_size, const uint64_t seed = 1):
+        kind_(kind), variables_size_(variables_size_for(kind, clauses_size)), random_(seed) {};
+
+    static uint32_t variables_size_for(const CnfGeneratorKind kind, const uint32_t clauses_size) {
+        switch (kind) {
+            case cgkRandom: return std::max<uint32_t>(3, (uint32_t)(clauses_size / 4.26));
+            case cgkCommunity: return std::max<uint32_t>(1, clauses_size / 4 / COMMUNITY_SIZE) * COMMUNITY_SIZE;
+            case cgkLarge: return std::max<uint32_t>(64, clauses_size / 2);
+        };
+        return 0;
+    };
+
+    static const char* name(const CnfGeneratorKind kind) {
+        switch (kind) {
+            case cgkRandom: return "random";
+            case cgkCommunity: return "community";
+            case cgkLarge: return "large";
+        };
+        return "unknown";
+    };
+
+    static bool parse_kind(const char* const name, CnfGeneratorKind& kind) {
+        for (const CnfGeneratorKind value: {cgkRandom, cgkCommunity, cgkLarge}) {
+            if (strcmp(name, CnfGenerator::name(value)) == 0) {
+                kind = value;
+                return true;
+            };
+        };
+        return false;
+    };
+
+    uint32_t variables_size() const { return variables_size_; };
+
+    // the next clause as DIMACS literals, without the terminating 0
+    void next(std::vector<int32_t>& literals) {
+        switch (kind_) {
+            case cgkRandom:
+                next_literals(3, 0, variables_size_, literals);
+                break;
+            case cgkCommunity: {
+                static const uint32_t sizes[8] = {2, 2, 2, 3, 3, 3, 4, 5};
+                const uint32_t size = sizes[next_uint32(8)];
+                if (next_uint32(10) != 0) {
+                    next_literals(size, next_uint32(variables_size_ / COMMUNITY_SIZE) * COMMUNITY_SIZE, COMMUNITY_SIZE, literals);
+                } else {
+                    next_literals(size, 0, variables_size_, literals);
+                };
+                break;
+            };
+            case cgkLarge:
+                next_literals(8 + next_uint32(57), 0, variables_size_, literals);
+                break;
+        };
+    };
+
+    // writes the formula in DIMACS format
+    void write_dimacs(std::ostream& stream, const uint32_t clauses_size) {
+        stream << "c generated by cgraph_bench: " << name(kind_) << ", " << clauses_size << " clauses\n";
+        stream << "p cnf " << variables_size_ << " " << clauses_size << "\n";
+        std::vector<int32_t> literals;
+        std::string line;
+        for (uint32_t i = 0; i < clauses_size; i++) {
+            next(literals);
+            line.clear();
+            for (const int32_t literal: literals) {
+                line += std::to_string(literal);
+                line += ' ';
+            };
+            line += "0\n";
+            stream << line;
+        };
+    };
+};
+
+#endif /* cnfgenerator_hpp */
@@ -5,28 +5,211 @@
 //  Published under terms of MIT license.
 //
 
+#include <cstdlib>
 #include <cstring>
 #include <string>
 #include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <system_error>
+#include <sys/stat.h>
 #include "cnf.hpp"
 #include "dimacs.hpp"
 #include "graphml.hpp"
+#include "graphmlstream.hpp"
+#include "csr.hpp"
+#include "metis.hpp"
+#include "cnfsnapshot.hpp"
+#include "louvain.hpp"
+#include "graphstatistics.hpp"
+#include "partitionmodularity.hpp"
 #include "fileutils.hpp"
+#include "statistics.hpp"
+#include "trace.hpp"
+#include "perfcounters.hpp"
 
 using namespace bal;
 
+enum OutputFormat {ofGraphML, ofCsr, ofMetis, ofHMetis, ofSnapshot};
+
+// the format and its default file name extension by the -f value
+bool parse_output_format(const char* const name, OutputFormat& format, const char*& extension) {
+    if (strcmp(name, "graphml") == 0) {
+        format = ofGraphML;
+        extension = ".graphml";
+    } else if (strcmp(name, "csr") == 0) {
+        format = ofCsr;
+        extension = ".csr";
+    } else if (strcmp(name, "metis") == 0) {
+        format = ofMetis;
+        extension = ".graph";
+    } else if (strcmp(name, "hmetis") == 0) {
+        format = ofHMetis;
+        extension = ".hgr";
+    } else if (strcmp(name, "snapshot") == 0) {
+        format = ofSnapshot;
+        extension = ".cnfs";
+    } else {
+        return false;
+    };
+    return true;
+};
+
+uint64_t get_file_size(const std::string& file_name) {
+    struct stat file_stat;
+    return stat(file_name.c_str(), &file_stat) == 0 ? (uint64_t)file_stat.st_size : 0;
+};
+
+// output size and the rate it was written at, from start until now
+void print_output_stats(const std::string& file_name, const std::chrono::steady_clock::time_point start) {
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    struct stat file_stat;
+    if (stat(file_name.c_str(), &file_stat) == 0) {
+        const double size_mb = file_stat.st_size / 1000000.0;
+        std::cout << "Output: " << std::fixed << std::setprecision(1) << size_mb << " MB";
+        std::cout << " in " << std::setprecision(2) << seconds << " s";
+        if (seconds > 0) {
+            std::cout << ", " << std::setprecision(1) << size_mb / seconds << " MB/s";
+        };
+        std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+    };
+};
+
+void print_graph_statistics(const GraphStatistics& statistics) {
+    const std::vector<uint64_t>& histogram = statistics.degrees_histogram();
+    uint64_t degrees_sum = 0;
+    for (size_t d = 0; d < histogram.size(); d++) {
+        degrees_sum += d * histogram[d];
+    };
+    std::cout << "Graph: " << statistics.nodes_size() << " nodes, " << statistics.edges_size() << " edges";
+    std::cout << ", degree max " << (histogram.empty() ? 0 : histogram.size() - 1) << ", average " << std::fixed << std::setprecision(2);
+    std::cout << (statistics.nodes_size() > 0 ? (double)degrees_sum / statistics.nodes_size() : 0) << std::endl;
+    // degree 0, then ranges of powers of 2
+    std::cout << "Degrees:";
+    for (size_t begin = 0; begin < histogram.size(); begin = begin > 0 ? begin * 2 : 1) {
+        const size_t end = std::min(begin > 0 ? begin * 2 : 1, histogram.size());
+        uint64_t nodes_size = 0;
+        for (size_t d = begin; d < end; d++) {
+            nodes_size += histogram[d];
+        };
+        std::cout << (begin > 0 ? ", " : " ") << begin;
+        if (end - 1 > begin) {
+            std::cout << "-" << end - 1;
+        };
+        std::cout << ": " << nodes_size;
+    };
+    std::cout << std::endl;
+    if (statistics.power_law_degree_min() > 0) {
+        std::cout << "Power law: alpha " << std::setprecision(3) << statistics.power_law_alpha();
+        std::cout << " for degrees from " << statistics.power_law_degree_min();
+        std::cout << ", KS distance " << statistics.power_law_distance() << std::endl;
+    } else {
+        std::cout << "Power law: too few nodes to fit" << std::endl;
+    };
+    std::cout << "Components: " << statistics.components_size() << ", largest " << statistics.largest_component_size() << " nodes" << std::endl;
+    std::cout << "Triangles: " << statistics.triangles_size() << ", global clustering " << std::setprecision(6) << statistics.global_clustering();
+    std::cout << ", average local clustering " << statistics.average_clustering() << std::endl;
+    std::cout << std::defaultfloat << std::setprecision(6);
+};
+
 int main(int argc, const char * argv[]) {
     std::cout << "CGraph 1.1 - Convert DIMACS CNF to Grapf ML" << std::endl;
     
     unsigned arg_index = 1;
     
     bool weighted = false;
+    bool sorted = false;
+    bool streaming = false;
+    unsigned threads_size = 1;
+    OutputFormat format = ofGraphML;
+    const char* format_extension = ".graphml";
+    container_memory_t clauses_memory = {cmHeap, false, std::string()};
+    bool compressed = false;
+    bool communities = false;
+    unsigned levels_max = Louvain::LEVELS_UNLIMITED;
+    bool partition = false;
+    bool graph_statistics = false;
+    PartitionMode partition_mode = pmResidual;
+    std::string stats_file_name;
+    std::string trace_file_name;
+    bool is_error = false;
     std::string input_file_name;
     std::string output_file_name;
     
-    if (arg_index < argc && strlen(argv[arg_index]) == 2 && argv[arg_index][0] == '-' && argv[arg_index][1] == 'w') {
-        weighted = true;
-        arg_index++;
+    while (arg_index < argc && argv[arg_index][0] == '-' && argv[arg_index][1] != 0) {
+        if (strcmp(argv[arg_index], "-w") == 0) {
+            weighted = true;
+            arg_index++;
+        } else if (strcmp(argv[arg_index], "-s") == 0) {
+            sorted = true;
+            arg_index++;
+        } else if (strcmp(argv[arg_index], "--stream") == 0) {
+            streaming = true;
+            arg_index++;
+        } else if (strcmp(argv[arg_index], "-j") == 0 && arg_index + 1 < argc) {
+            char* value_end = nullptr;
+            threads_size = (unsigned)strtoul(argv[arg_index + 1], &value_end, 10);
+            if (value_end == argv[arg_index + 1] || *value_end != 0) {
+                is_error = true;
+                break;
+            };
+            arg_index += 2;
+        } else if (strcmp(argv[arg_index], "--mmap") == 0) {
+            clauses_memory.type = cmMapped;
+            arg_index++;
+        } else if (strcmp(argv[arg_index], "--huge-pages") == 0) {
+            clauses_memory.is_huge_pages = true;
+            arg_index++;
+        } else if (strcmp(argv[arg_index], "--spill") == 0 && arg_index + 1 < argc) {
+            clauses_memory.type = cmFile;
+            clauses_memory.directory = argv[arg_index + 1];
+            arg_index += 2;
+        } else if (strcmp(argv[arg_index], "--stats") == 0 && arg_index + 1 < argc) {
+            stats_file_name = argv[arg_index + 1];
+            arg_index += 2;
+        } else if (strcmp(argv[arg_index], "--trace") == 0 && arg_index + 1 < argc) {
+            trace_file_name = argv[arg_index + 1];
+            arg_index += 2;
+        } else if (strcmp(argv[arg_index], "--compress") == 0) {
+            compressed = true;
+            arg_index++;
+        } else if (strcmp(argv[arg_index], "--partition") == 0 && arg_index + 1 < argc) {
+            if (strcmp(argv[arg_index + 1], "residual") == 0) {
+                partition_mode = pmResidual;
+            } else if (strcmp(argv[arg_index + 1], "nearest") == 0) {
+                partition_mode = pmNearest;
+            } else {
+                is_error = true;
+                break;
+            };
+            partition = true;
+            arg_index += 2;
+        } else if (strcmp(argv[arg_index], "--graph-stats") == 0) {
+            graph_statistics = true;
+            arg_index++;
+        } else if (strcmp(argv[arg_index], "--communities") == 0) {
+            communities = true;
+            arg_index++;
+        } else if (strcmp(argv[arg_index], "--levels") == 0 && arg_index + 1 < argc) {
+            char* value_end = nullptr;
+            levels_max = (unsigned)strtoul(argv[arg_index + 1], &value_end, 10);
+            if (value_end == argv[arg_index + 1] || *value_end != 0) {
+                is_error = true;
+                break;
+            };
+            communities = true;
+            arg_index += 2;
+        } else if (strcmp(argv[arg_index], "-f") == 0 && arg_index + 1 < argc) {
+            if (!parse_output_format(argv[arg_index + 1], format, format_extension)) {
+                is_error = true;
+                break;
+            };
+            arg_index += 2;
+        } else {
+            is_error = true;
+            break;
+        };
     };
     
     if (arg_index < argc) {
@@ -40,32 +223,230 @@ int main(int argc, const char * argv[]) {
     };
     
     if (output_file_name.empty()) {
-        output_file_name = input_file_name + ".graphml";
+        output_file_name = input_file_name + format_extension;
+    };
+    
+    // weights need all clauses to be known, other formats need the complete graph
+    // snapshots are loaded whole
+    const bool is_snapshot = !input_file_name.empty() && is_cnf_snapshot_file(input_file_name.c_str());
+    if (streaming && (weighted || format != ofGraphML || is_snapshot)) {
+        is_error = true;
+    };
+    // snapshots keep clauses as they are stored
+    if (compressed && (streaming || format == ofSnapshot)) {
+        is_error = true;
+    };
+    // communities, partitions and graph statistics need all clauses
+    if ((communities || partition || graph_statistics) && streaming) {
+        is_error = true;
+    };
+    // huge pages apply to anonymous memory mappings only
+    if (clauses_memory.is_huge_pages && clauses_memory.type != cmMapped) {
+        is_error = true;
+    };
+    // communities are written as a GraphML node attribute, other formats have no place for them
+    if (communities && format != ofGraphML) {
+        is_error = true;
     };
     
-    if (!input_file_name.empty()) {
+    // phases are always reported, long reads report progress
+    if (!is_error && !input_file_name.empty()) {
+        trace_enable(true);
+    };
+    
+    // hardware events per phase with statistics, before any threads are created so they are counted
+    if (!is_error && !input_file_name.empty() && !stats_file_name.empty()) {
+        std::string error;
+        if (!perf_counters_open(error)) {
+            std::cout << "Performance counters not available: " << error << std::endl;
+        };
+    };
+    
+    if (!is_error && !input_file_name.empty() && streaming) {
+        std::cout << "Input file: " << input_file_name << std::endl;
+        std::cout << "Output file: " << output_file_name << std::endl;
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::ofstream output_file(output_file_name);
+        if (output_file.is_open()) {
+            Cnf cnf;
+            GraphMLStreamingWriter writer(output_file, sorted, threads_size);
+            {
+                TraceSpan span(stRead, "clauses");
+                read_from_file<Cnf, DimacsGraphMLStreamReader>(cnf, input_file_name.c_str(), writer);
+                writer.flush();
+                span.set_bytes(get_file_size(input_file_name));
+                span.set_items(writer.clauses_size());
+            };
+            output_file.close();
+            
+            std::cout << "CNF: " << std::dec;
+            std::cout << cnf.variables_size() << " variables";
+            std::cout << ", " << writer.clauses_size()  << " clauses";
+            std::cout << ", " << writer.literals_size() << " literals";
+            std::cout << " (not aggregated)" << std::endl;
+            std::cout << "Graph: " << writer.edges_size() << " edges" << std::endl;
+            // reading and writing overlap, so the rate includes parsing
+            print_output_stats(output_file_name, start);
+        } else {
+            std::cout << "Error: canot open the file \"" << output_file_name << "\"." << std::endl;
+        };
+    } else if (!is_error && !input_file_name.empty()) {
         std::cout << "Input file: " << input_file_name << std::endl;
         Cnf cnf;
-        read_from_file<Cnf, DimacsStreamReader>(cnf, input_file_name.c_str());
+        if (!cnf.set_clauses_memory(clauses_memory)) {
+            std::cout << "Error: cannot create a temporary file in \"" << clauses_memory.directory << "\"." << std::endl;
+            return 1;
+        };
+        {
+            TraceSpan span(stRead, "clauses");
+            if (is_snapshot) {
+                CnfSnapshotReader reader;
+                if (!reader.read(cnf, input_file_name.c_str())) {
+                    std::cout << "Error: cannot load the snapshot \"" << input_file_name << "\": " << reader.error() << "." << std::endl;
+                    return 1;
+                };
+            } else {
+                try {
+                    read_from_file<Cnf, DimacsStreamReader>(cnf, input_file_name.c_str(), threads_size);
+                }
+                catch (std::system_error& e) {
+                    // the clauses cannot grow, e.g. the disk is full with --spill
+                    std::cout << "Error: cannot keep the clauses: " << e.what() << "." << std::endl;
+                    return 1;
+                };
+            };
+            span.set_bytes(get_file_size(input_file_name));
+            span.set_items(cnf.clauses_size());
+        };
         
         std::cout << "CNF: " << std::dec;
         std::cout << cnf.variables_size() << " variables";
         std::cout << ", " << cnf.clauses_size()  << " clauses";
         std::cout << ", " << cnf.literals_size() << " literals";
+        if (cnf.duplicate_clauses_size() > 0) {
+            std::cout << ", " << cnf.duplicate_clauses_size() << " duplicate clauses ignored";
+        };
         std::cout << std::endl;
         
-        std::cout << "Output file: " << output_file_name << std::endl;
-        if (weighted) {
-            write_to_file<Cnf, GraphMLWeightedStreamWriter>(cnf, output_file_name.c_str());
-        } else {
-            write_to_file<Cnf, GraphMLStreamWriter>(cnf, output_file_name.c_str());
+        uint32_t index_depth_max;
+        double index_depth_average;
+        cnf.get_clauses_index_depth(index_depth_max, index_depth_average);
+        std::cout << "Clauses index: depth " << index_depth_max << " max, ";
+        std::cout << std::fixed << std::setprecision(1) << index_depth_average << " average";
+        std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+        
+        if (compressed) {
+            const size_t memory_size = cnf.memory_size_clauses();
+            {
+                TraceSpan span(stCompress);
+                cnf.compress_clauses();
+                span.set_bytes(memory_size);
+            };
+            std::cout << "Clauses memory: " << memory_size << " bytes, " << cnf.memory_size_clauses() << " bytes compressed" << std::endl;
+        };
+        
+        if (partition) {
+            const NamedPartition named_partition(cnf, partition_mode, threads_size);
+            PartitionModularity partition_modularity;
+            partition_modularity.run(cnf, named_partition.communities(), named_partition.communities_size(), threads_size);
+            std::cout << "Named variables partition: " << named_partition.communities_size() << " communities";
+            std::cout << ", modularity " << std::fixed << std::setprecision(6) << partition_modularity.modularity() << std::endl;
+            for (uint32_t i = 0; i < named_partition.communities_size(); i++) {
+                const std::string& name = named_partition.name(i);
+                std::cout << "  " << (name.empty() ? "(unnamed)" : name) << ": " << partition_modularity.variables_sizes()[i] << " variables";
+                std::cout << ", inner weight " << partition_modularity.inner_weights()[i];
+                std::cout << ", outer weight " << partition_modularity.outer_weights()[i] << std::endl;
+            };
+            std::cout << std::defaultfloat << std::setprecision(6);
+        };
+        
+        Louvain louvain(threads_size);
+        if (communities || graph_statistics) {
+            const VariableIncidenceGraph graph(cnf, threads_size);
+            if (graph_statistics) {
+                GraphStatistics statistics(threads_size);
+                statistics.run(graph);
+                print_graph_statistics(statistics);
+            };
+            if (communities) {
+                louvain.run(graph, levels_max);
+            };
+        };
+        if (communities) {
+            std::cout << "Communities: " << louvain.communities_size() << " in " << louvain.levels() << " levels";
+            std::cout << ", modularity " << std::fixed << std::setprecision(6) << louvain.modularity();
+            std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+        };
+        // the community of each variable is written to GraphML
+        const std::vector<uint32_t>* const p_communities = communities ? &louvain.communities() : nullptr;
+        
+        // graph statistics replace the output
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool is_written = false;
+        if (!graph_statistics) {
+            std::cout << "Output file: " << output_file_name << std::endl;
+            TraceSpan span(stWrite);
+            if (format == ofCsr) {
+                is_written = write_to_file<Cnf, CsrStreamWriter>(cnf, output_file_name.c_str(), weighted, threads_size);
+            } else if (format == ofMetis) {
+                is_written = write_to_file<Cnf, MetisStreamWriter>(cnf, output_file_name.c_str(), weighted, threads_size);
+            } else if (format == ofHMetis) {
+                is_written = write_to_file<Cnf, HMetisStreamWriter>(cnf, output_file_name.c_str(), weighted, threads_size);
+            } else if (format == ofSnapshot) {
+                is_written = write_to_file<Cnf, CnfSnapshotStreamWriter>(cnf, output_file_name.c_str());
+            } else if (weighted) {
+                is_written = write_to_file<Cnf, GraphMLWeightedStreamWriter>(cnf, output_file_name.c_str(), threads_size, p_communities);
+            } else {
+                is_written = write_to_file<Cnf, GraphMLStreamWriter>(cnf, output_file_name.c_str(), sorted, threads_size, p_communities);
+            };
+            span.set_bytes(get_file_size(output_file_name));
+        };
+        if (is_written) {
+            print_output_stats(output_file_name, start);
         };
     } else {
         std::cout << "Usage:" << std::endl;
-        std::cout << "  cgraph [-w] <input file name> [<output file name>]" << std::endl;
-        std::cout << "  <input file name> - input DIMACS CNF file name" << std::endl;
-        std::cout << "  <output file name> - output Graph ML file name" << std::endl;
+        std::cout << "  cgraph [-w | --stream] [-s] [-j <threads>] [-f <format>] [--mmap [--huge-pages] | --spill <directory>] [--compress] [--communities] [--levels <levels>] [--partition <mode>] [--graph-stats] [--stats <file name>] [--trace <file name>] <input file name> [<output file name>]" << std::endl;
+        std::cout << "  <input file name> - input DIMACS CNF or snapshot file name" << std::endl;
+        std::cout << "  <output file name> - output file name, the input one with the format extension by default" << std::endl;
         std::cout << "  w - include edge weight and cardinality" << std::endl;
+        std::cout << "  stream - write the graph while reading clauses, without keeping them in memory" << std::endl;
+        std::cout << "  s - write edges sorted by variables rather than in the order of occurrence" << std::endl;
+        std::cout << "  j - number of threads for parsing, weights and output, 0 for all available, 1 by default" << std::endl;
+        std::cout << "  f - output format: graphml (default), csr (binary), metis, hmetis or snapshot (the formula for reloading)" << std::endl;
+        std::cout << "  mmap - keep clauses in memory mappings, grown without copying" << std::endl;
+        std::cout << "  huge-pages - back the memory mappings with transparent huge pages, with --mmap only" << std::endl;
+        std::cout << "  spill - keep clauses in a temporary file in the directory, for formulas larger than memory" << std::endl;
+        std::cout << "  compress - compress clauses once loaded, decoded in blocks while writing the graph; not with snapshot" << std::endl;
+        std::cout << "  communities - find communities of variables by the Louvain method, print modularity and write them as a GraphML node attribute; GraphML only" << std::endl;
+        std::cout << "  levels - stop finding communities after the number of levels, implies communities" << std::endl;
+        std::cout << "  partition - print modularity of the partition into named variables; unnamed variables are one residual community, or join the nearest named variable with nearest" << std::endl;
+        std::cout << "  graph-stats - print metrics of the graph instead of writing it: degrees, power law fit, components, triangles and clustering" << std::endl;
+        std::cout << "  stats - write counters and phase times to the file as JSON, with hardware events per phase where available" << std::endl;
+        std::cout << "  trace - write the phases to the file in Chrome trace_event format" << std::endl;
+    };
+    
+    if (!is_error && !input_file_name.empty()) {
+        std::cout << "Phases:" << std::endl;
+        trace_print(std::cout);
+    };
+    
+    if (!is_error && !input_file_name.empty() && !trace_file_name.empty()) {
+        std::ofstream trace_file(trace_file_name);
+        if (!trace_file.is_open()) {
+            std::cout << "Error: cannot open the file \"" << trace_file_name << "\"." << std::endl;
+            return 1;
+        };
+        trace_write_chrome_json(trace_file);
+    };
+    
+    if (!is_error && !input_file_name.empty() && !stats_file_name.empty()) {
+        std::ofstream stats_file(stats_file_name);
+        if (!stats_file.is_open()) {
+            std::cout << "Error: cannot open the file \"" << stats_file_name << "\"." << std::endl;
+            return 1;
+        };
+        statistics_write_json(stats_file, statistics_get());
     };
     return 0;
 }
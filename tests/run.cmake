@@ -0,0 +1,17 @@
+#
+#  Boolean Algebra Library (BAL)
+#  https://cgen.sophisticatedways.net
+#  Copyright © 2018 Volodymyr Skladanivskyy. All rights reserved.
+#  Published under terms of MIT license.
+#
+
+# converts INPUT with cgraph and OPTIONS into OUTPUT and compares it with EXPECTED
+separate_arguments(OPTIONS)
+execute_process(COMMAND ${CGRAPH} ${OPTIONS} ${INPUT} ${OUTPUT} RESULT_VARIABLE result OUTPUT_QUIET)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "cgraph ${OPTIONS} ${INPUT} failed: ${result}")
+endif()
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${OUTPUT} ${EXPECTED} RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "${OUTPUT} differs from ${EXPECTED}")
+endif()